@@ -3,110 +3,57 @@
 */
 #include "SimplexNode.h"
 
-ListNode::ListNode(const ListNode &rhs)
-{
-	row = rhs.row;
-	val = rhs.val;
-	next = rhs.next;
-	right = rhs.right;
-	left = rhs.left;
-}
-ListNode& ListNode::operator=(const ListNode &rhs) {
-	if (this != &rhs) {
-		row = rhs.row;
-		val = rhs.val;
-		next = rhs.next;
-		right = rhs.right;
-		left = rhs.left;
-	}
-	return *this;
-}
-ListNodePtr AnnotationMatrix::DeepCopyAnnotationColumn(const ListNodePtr &head) {
-	/*create the dummy node*/
-	ListNodePtr new_head(boost::make_shared<ListNode>());
-	std::unordered_map<ListNodePtr, TreeRootNodePtr, hash_ListNodePtr, equal_ListNodePtr>::iterator findIter = ann_mat.find(head);
-	if (findIter != ann_mat.end())
+AnnotationColumnPtr AnnotationMatrix::DeepCopyAnnotationColumn(const AnnotationColumnPtr &head) {
+	std::unordered_map<AnnotationColumnPtr, TreeRootNodePtr, hash_AnnotationColumnPtr, equal_AnnotationColumnPtr>::iterator findIter = ann_mat.find(head);
+	if (findIter == ann_mat.end())
 	{
-		if (head->next == head) {
-			// zero annotation
-			new_head->next = new_head;
-			return new_head;
-		}
-		/*pointing to the dummy head*/
-		ListNodePtr trav = head;
-		/*point to the first element */
-		trav = trav->next;
-	
-		//copy the first element
-		new_head->next = boost::make_shared<ListNode>(trav->row, trav->val);
-		new_head->next->next = new_head;
-		//
-		ListNodePtr tail = new_head->next;
-		trav = trav->next;
-		while (trav != head) {
-			//copy the element
-			tail->next = boost::make_shared<ListNode>(trav->row, trav->val);
-			trav = trav->next;
-			tail = tail->next;
-			tail->next = new_head;
-		}
-	}
-	else {
-		// zero annotation;
-		ListNodePtr trav = head;
-		trav = trav->next;
-		while (trav != head) {
-			cout << trav->row << " ";
-			trav = trav->next;
+		// not an annotation of this matrix
+		for (size_t i = 0; i < head->rows.size(); ++i) {
+			cout << head->rows[i] << " ";
 		}
 		cout << endl;
-		for (unordered_map<int, ListNodePtr>::iterator mIter = row_ptr.begin();
+		for (unordered_map<int, AnnotationRowMembers>::iterator mIter = row_ptr.begin();
 			mIter != row_ptr.end(); ++mIter) {
 			cout << mIter->first << endl;
 		}
 		exit(0);
-		return ListNodePtr();  // return nullptr
+		return AnnotationColumnPtr();  // return nullptr
 	}
+	AnnotationColumnPtr new_head(boost::make_shared<AnnotationColumn>());
+	new_head->rows = head->rows;
+	new_head->hash = head->hash;
 	//
 	return new_head;
 }
-ListNodePtr AnnotationMatrix::create_cocycle(TreeRootNodePtr &root, UnionFindDeletion &ufd, bool zero_elem){
+AnnotationColumnPtr AnnotationMatrix::create_cocycle(TreeRootNodePtr &root, UnionFindDeletion &ufd, bool zero_elem){
 	if (zero_elem) {
-		ListNodePtr p(boost::make_shared<ListNode>());
-		p->next = p;
+		AnnotationColumnPtr p(boost::make_shared<AnnotationColumn>());
 		//
 		Insert(p, root, ufd);
 		// 
 		return p;
 	}
 	// not the zero element
-
-	// generate the dummy node first
-	ListNodePtr p(boost::make_shared<ListNode>());
-	p->next = boost::make_shared<ListNode>(timeStamp, 1);
+	AnnotationColumnPtr p(boost::make_shared<AnnotationColumn>((uint32_t)timeStamp));
 	timeStamp += 1;
-	p->next->next = p; // make it circular
 	// link root to p
 	Insert(p, root, ufd);
 	//
 	return p;
 }
-void AnnotationMatrix::Insert(ListNodePtr &ptr, const TreeRootNodePtr root, UnionFindDeletion &ufd)
+void AnnotationMatrix::Insert(AnnotationColumnPtr &ptr, const TreeRootNodePtr root, UnionFindDeletion &ufd)
 {
 	if (!search(ptr))
 	{
-		// insert the list
+		// insert the column
 		ann_mat[ptr] = root;
 		// link p to root 
 		root->attribute = ptr;
-		// link into row lists
-		// move to the first element
-		ListNodePtr p(ptr->next);
-		while (p != ptr)
+		// add to the member lists of its rows
+		ptr->slots.resize(ptr->rows.size());
+		for (size_t i = 0; i < ptr->rows.size(); ++i)
 		{
-			insert_into_doubly_linked_list(p->row, p);
-			//
-			p = p->next;
+			insert_into_row(ptr, i);
 		}
 	}
 	else {
@@ -118,57 +65,48 @@ void AnnotationMatrix::Insert(ListNodePtr &ptr, const TreeRootNodePtr root, Unio
 		// update cluster associated with the annotation 
 		newRoot->attribute = ann_mat.find(ptr)->first;
 		ann_mat[ptr] = newRoot;
-		//clear listNode "ptr"
-		ptr->next.reset();
 		ptr = newRoot->attribute;
 	}
 	return;
 }
 
-void AnnotationMatrix::clearNode(ListNodePtr &ptr, bool bUpdatePers)
+void AnnotationMatrix::clearNode(AnnotationColumnPtr &ptr, bool bUpdatePers)
 {//
 
-	std::unordered_map<ListNodePtr, TreeRootNodePtr, hash_ListNodePtr, equal_ListNodePtr>::iterator findIter = ann_mat.find(ptr);
+	std::unordered_map<AnnotationColumnPtr, TreeRootNodePtr, hash_AnnotationColumnPtr, equal_AnnotationColumnPtr>::iterator findIter = ann_mat.find(ptr);
 	if (findIter != ann_mat.end())
 	{
-		// delete from the row list
-		// move to the first element
-		ListNodePtr p(findIter->first->next);
-		while (p != findIter->first)
+		// delete from the member lists of its rows
+		AnnotationColumnPtr col(findIter->first);
+		for (size_t i = 0; i < col->rows.size(); ++i)
 		{
-			delete_from_doubly_linked_list(p->row, p, bUpdatePers);
-			p = p->next;
+			delete_from_row(col, i, bUpdatePers);
 		}
-		// delete from the list
+		// delete from the matrix
 		TreeRootNodePtr ret = findIter->second;
 		ret->attribute.reset(); // unlink the root with annotation
 		//
 		ann_mat.erase(findIter);
-		//break cycle
-		p->next.reset();
 		return;
 	}
 	//
 	return;
 }
 
-TreeRootNodePtr AnnotationMatrix::Delete(ListNodePtr &ptr)
+TreeRootNodePtr AnnotationMatrix::Delete(AnnotationColumnPtr &ptr)
 {//
 
-	std::unordered_map<ListNodePtr, TreeRootNodePtr, hash_ListNodePtr, equal_ListNodePtr>::iterator findIter = ann_mat.find(ptr);
+	std::unordered_map<AnnotationColumnPtr, TreeRootNodePtr, hash_AnnotationColumnPtr, equal_AnnotationColumnPtr>::iterator findIter = ann_mat.find(ptr);
 	if (findIter != ann_mat.end())
 	{
-		// delete from the row list
-		// move to the first element
-		ListNodePtr p(findIter->first->next);
-		while (p != findIter->first)
+		// delete from the member lists of its rows
+		AnnotationColumnPtr col(findIter->first);
+		for (size_t i = 0; i < col->rows.size(); ++i)
 		{
 			//don't update persistences
-			delete_from_doubly_linked_list(p->row, p, false);
-			//
-			p = p->next;
+			delete_from_row(col, i, false);
 		}
-		// delete from the list
+		// delete from the matrix
 		TreeRootNodePtr ret = findIter->second;
 		ret->attribute.reset(); // unlink the root with annotation
 		//
@@ -176,9 +114,9 @@ TreeRootNodePtr AnnotationMatrix::Delete(ListNodePtr &ptr)
 		return ret;
 	}
 	//
-	return boost::make_shared<TreeRootNode>();
+	return TreeRootNodePtr();
 }
-int AnnotationMatrix::sum_two_annotation_with_changed_dst(ListNodePtr & out_dst, ListNodePtr & in_src) {
+int AnnotationMatrix::sum_two_annotation_with_changed_dst(AnnotationColumnPtr & out_dst, AnnotationColumnPtr & in_src) {
 	// change dst and keep src unchanged 
 
 	if (!in_src) {
@@ -190,74 +128,110 @@ int AnnotationMatrix::sum_two_annotation_with_changed_dst(ListNodePtr & out_dst,
 		out_dst = DeepCopyAnnotationColumn(in_src);
 		return lowest_one(out_dst);
 	}
-	ListNodePtr dst_prev(out_dst);
-	ListNodePtr dst_trav(out_dst->next);
-	ListNodePtr src_trav(in_src->next);
-
-	while (dst_trav != out_dst && src_trav != in_src) {
-		if (dst_trav->row == src_trav->row) {
-			// thest two should be canceled
-			dst_prev->next = dst_trav->next;
-			//
-			dst_trav = dst_trav->next;
-			src_trav = src_trav->next;
-		}
-		else {
-			if (dst_trav->row > src_trav->row) {
-				ListNodePtr temp(boost::make_shared<ListNode>(src_trav->row, 1));
-				dst_prev->next = temp;
-				temp->next = dst_trav;
-
-				dst_prev = temp;
-				src_trav = src_trav->next;
-			}
-			else {
-				dst_prev = dst_trav;
-				dst_trav = dst_trav->next;
-			}
-		}
+	// merge the two sorted arrays, dropping the rows they share
+	const std::vector<uint32_t> &dst = out_dst->rows;
+	const std::vector<uint32_t> &src = in_src->rows;
+	sum_buffer.resize(dst.size() + src.size());
+	const uint32_t *a = dst.data(), *a_end = a + dst.size();
+	const uint32_t *b = src.data(), *b_end = b + src.size();
+	uint32_t *out = sum_buffer.data();
+	while (a != a_end && b != b_end) {
+		const uint32_t x = *a, y = *b;
+		// no branch on the comparison; equal rows are written and not kept
+		*out = (x < y ? x : y);
+		out += (x != y);
+		a += (x <= y);
+		b += (y <= x);
 	}
-	while (src_trav != in_src) {
-		dst_prev->next = boost::make_shared<ListNode>(src_trav->row, 1);
-		dst_prev = dst_prev->next;
-		dst_prev->next = out_dst;
+	out = std::copy(a, a_end, out);
+	out = std::copy(b, b_end, out);
+	sum_buffer.resize(out - sum_buffer.data());
+	// the old rows become the scratch space of the next sum
+	out_dst->rows.swap(sum_buffer);
+	out_dst->hash ^= in_src->hash;
+	return lowest_one(out_dst);
+}
 
-		src_trav = src_trav->next;
-	}
-	while (dst_prev->next != out_dst) {
-		dst_prev = dst_prev->next;
+int AnnotationMatrix::lowest_one(AnnotationColumnPtr & head) {
+	if (head && !head->rows.empty()) {
+		return head->rows.back();
 	}
-	return (out_dst->next != out_dst ? dst_prev->row : -1);
+	return -1;
 }
-
-int AnnotationMatrix::lowest_one(ListNodePtr & head) {
-	if (head) {
-		ListNodePtr trav(head->next);
-		if (trav == head) {
-			return -1;
+void AnnotationMatrix::add_to_stored_column(AnnotationColumnPtr &col, const AnnotationColumnPtr &src, const int u) {
+	const std::vector<uint32_t> &dst = col->rows;
+	const std::vector<uint32_t> &rows = src->rows;
+	sum_buffer.clear();
+	slot_buffer.clear();
+	size_t i = 0, j = 0;
+	while (i < dst.size() || j < rows.size()) {
+		if (j == rows.size() || (i < dst.size() && dst[i] < rows[j])) {
+			// row of col only: it stays where it is
+			sum_buffer.push_back(dst[i]);
+			slot_buffer.push_back(col->slots[i]);
+			++i;
 		}
-		while (trav->next != head) {
-			trav = trav->next;
+		else if (i == dst.size() || rows[j] < dst[i]) {
+			// row of src only: col joins the row
+			AnnotationRowMembers &members = row_ptr[rows[j]];
+			sum_buffer.push_back(rows[j]);
+			slot_buffer.push_back((uint32_t)members.size());
+			members.push_back(col);
+			++j;
+		}
+		else {
+			// canceled: col leaves the row
+			if (dst[i] != (uint32_t)u)
+				delete_from_row(col, i, false);
+			++i;
+			++j;
 		}
-		return trav->row;
 	}
-	return -1;
+	col->rows.swap(sum_buffer);
+	col->slots.swap(slot_buffer);
+	col->hash ^= src->hash;
+	return;
 }
-void AnnotationMatrix::kill_cocycle_last_nonzero_bit(const int u, ListNodePtr &ext_src, UnionFindDeletion &ufd){
+void AnnotationMatrix::kill_cocycle_last_nonzero_bit(const int u, AnnotationColumnPtr &ext_src, UnionFindDeletion &ufd){
 	// add every annotation with nonzero u-th bit by exteranl annotation ext_src
-	while (row_ptr.find(u) != row_ptr.end()) {
-		ListNodePtr mid_node = row_ptr[u];
-		// the dummy head has row of -1
-		while (mid_node->row != -1) {
-			mid_node = mid_node->next;
+	// all at once; bit u vanishes from the matrix
+	std::unordered_map<int, AnnotationRowMembers>::iterator findIter = row_ptr.find(u);
+	if (findIter == row_ptr.end())
+		return;
+	AnnotationRowMembers killed;
+	killed.swap(findIter->second);
+	row_ptr.erase(findIter);
+	// take the columns out of ann_mat before their hashes change
+	std::vector<TreeRootNodePtr> roots(killed.size());
+	for (size_t i = 0; i < killed.size(); ++i) {
+		std::unordered_map<AnnotationColumnPtr, TreeRootNodePtr, hash_AnnotationColumnPtr, equal_AnnotationColumnPtr>::iterator matIter = ann_mat.find(killed[i]);
+		roots[i] = matIter->second;
+		ann_mat.erase(matIter);
+	}
+	for (size_t i = 0; i < killed.size(); ++i) {
+		add_to_stored_column(killed[i], ext_src, u);
+	}
+	// put them back; a column that now equals another annotation merges its
+	// cluster into the other one. No two of them collide, as they differed
+	// before the same column was added to each
+	for (size_t i = 0; i < killed.size(); ++i) {
+		AnnotationColumnPtr &col = killed[i];
+		std::unordered_map<AnnotationColumnPtr, TreeRootNodePtr, hash_AnnotationColumnPtr, equal_AnnotationColumnPtr>::iterator matIter = ann_mat.find(col);
+		if (matIter == ann_mat.end()) {
+			ann_mat[col] = roots[i];
+			continue;
+		}
+		for (size_t j = 0; j < col->rows.size(); ++j) {
+			delete_from_row(col, j, false);
 		}
-		// mide_node is the dummy head now
-		// remove it from the annotation matrix
-		TreeRootNodePtr x = Delete(mid_node);
-		sum_two_annotation_with_changed_dst(mid_node, ext_src);
-		// the simplex has new annotation 
-		// insert the simplex back to the forest
-		Insert(mid_node, x, ufd);
+		// merge the two clusters
+		TreeRootNodePtr root1 = matIter->second;
+		root1->attribute.reset(); //unlink tree with annotation
+		roots[i]->attribute.reset();
+		TreeRootNodePtr newRoot = ufd.Union(root1, roots[i]); // merge two trees
+		// update cluster associated with the annotation 
+		newRoot->attribute = matIter->first;
+		matIter->second = newRoot;
 	}
 	return;
 }
\ No newline at end of file
@@ -21,20 +21,22 @@
 
 #include <boost/dynamic_bitset.hpp>
 #include <boost/unordered_map.hpp>
-#include <boost/pending/mutable_queue.hpp>
 #include <boost/timer.hpp>
 #include <boost/progress.hpp>
 #include <boost/checked_delete.hpp>
 #include <boost/math/special_functions/round.hpp>
-
-#include <CGAL/Homogeneous_d.h>
-#include <CGAL/predicates_d.h>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/ref.hpp>
 
 #include <Grid.h>
 
 #include <Indexed.h>
 #include <Flagged.h>
 #include <Normed.h>
+#include <Z2_basis.h>
+#include <Dary_heap.h>
 
 // this is the distance matrix used for matrix input
 extern vector< vector<double> > g_distance_matrix;
@@ -68,8 +70,6 @@ namespace trackLoop
 
 		enum
 		{
-			IS_IN_QUEUE = 1,
-			IS_IN_TREE = 1 << 1,
 			IS_IN_SAMPLE = 1 << 2
 		};
 				
@@ -87,20 +87,6 @@ namespace trackLoop
 
 		Vertex< Kernel_ > const &coneighbor( Edge< Kernel_ > const &edge_ ) const;
 		Vertex< Kernel_ > &coneighbor( Edge< Kernel_ > &edge_ );
-		
-		double distance_to_root() const;
-		void set_distance_to_root( double distance_to_root_ );
-		
-		boost::dynamic_bitset<> const &contracted_path_to_root() const;
-		boost::dynamic_bitset<> &contracted_path_to_root();
-				
-		bool has_parent() const;
-		Vertex const &parent() const;
-		Vertex &parent();
-		Edge< Kernel_ > const &edge_to_parent() const;
-		Edge< Kernel_ > &edge_to_parent();
-		void set_edge_to_parent( Edge< Kernel_ > &edge_to_parent_ );
-		void clear_edge_to_parent();
 
 		Vertex const &image() const;
 		Vertex &image();
@@ -114,15 +100,6 @@ namespace trackLoop
 		// Edges having this vertex as a face
 		Coboundary m_coboundary;
 
-		// Distance to the root in some shortest path tree
-		double m_distance_to_root;
-
-		// Path to the root in the contracted complex
-		boost::dynamic_bitset<> m_contracted_path_to_root;
-
-		// Edge connecting this vertex to its parent in some shortest path tree
-		Edge< Kernel_ > *m_p_edge_to_parent;
-
 		// Image in the contracted complex
 		Vertex *m_p_image;
 	};
@@ -142,7 +119,6 @@ namespace trackLoop
 
 		enum
 		{
-			IS_IN_TREE = 1,
 			IS_IN_LOOP = 1 << 2
 		};
 
@@ -158,9 +134,6 @@ namespace trackLoop
 
 		double length() const;
 
-		double canonical_loop_length() const;
-		void set_canonical_loop_length( double canonical_loop_length_ );
-
 		std::vector< Edge< Kernel_ > * > const &image() const;
 		std::vector< Edge< Kernel_ > * > &image();
 
@@ -170,11 +143,6 @@ namespace trackLoop
 		
 		double m_length;
 
-		// Length of the canonical loop in some shortest path tree;
-		// canonical loop is formed by the edge and two chains connecting
-		// the endpoints of the edge to the root of the shortest path tree
-		double m_canonical_loop_length;
-
 		// Image in the contracted complex; may contain multiple edges 
 		// (e.g. when contracting a triangle abc, ab may be mapped to {ac, bc}
 		std::vector< Edge< Kernel_ > * > m_image;
@@ -228,7 +196,7 @@ namespace trackLoop
 	public:
 
 		Canonical_loop( Vertex< Kernel_ > &vertex_, Edge< Kernel_ > &edge_,
-			boost::dynamic_bitset<> const &bits_ );
+			boost::dynamic_bitset<> const &bits_, double length_ );
 
 		Vertex< Kernel_ > const &vertex() const;
 		Edge< Kernel_ > const &edge() const;
@@ -283,6 +251,117 @@ namespace trackLoop
 		Container m_edges;
 	};
 
+	///////////////////////////////////////////////////////////////////////////
+	//
+	// Holds a shortest path tree rooted at some vertex. The state is kept in
+	// arrays indexed by vertex and edge indices rather than in the vertices
+	// and edges themselves, so that several trees can be grown over the same
+	// complex at once (one per thread of the canonical loop search).
+	//
+	///////////////////////////////////////////////////////////////////////////
+
+	template< typename Kernel_ >
+	class Shortest_path_tree
+	{
+
+	public:
+
+		// Sizes the arrays for the given complex, which may have grown since
+		// the last call, and empties the tree; only the touched and the new
+		// entries are visited
+		void resize( unsigned number_of_vertices_, unsigned number_of_edges_ );
+
+		double distance_to_root( Vertex< Kernel_ > const &vertex_ ) const;
+		void set_distance_to_root( Vertex< Kernel_ > const &vertex_,
+			double distance_to_root_ );
+
+		// Nearest vertex on the path to the root, the vertex itself
+		// included, whose edge to the parent has a nonempty image; 0 if
+		// there is none
+		Vertex< Kernel_ > *image_ancestor( Vertex< Kernel_ > const &vertex_ ) const;
+		// Number of edges with a nonempty image on the path to the root
+		unsigned image_depth( Vertex< Kernel_ > const &vertex_ ) const;
+		void set_image_ancestor( Vertex< Kernel_ > const &vertex_,
+			Vertex< Kernel_ > *p_image_ancestor_, unsigned image_depth_ );
+
+		bool has_parent( Vertex< Kernel_ > const &vertex_ ) const;
+		Vertex< Kernel_ > &parent( Vertex< Kernel_ > const &vertex_ ) const;
+		Edge< Kernel_ > &edge_to_parent( Vertex< Kernel_ > const &vertex_ ) const;
+		void set_edge_to_parent( Vertex< Kernel_ > const &vertex_,
+			Edge< Kernel_ > &edge_to_parent_ );
+
+		bool is_in_queue( Vertex< Kernel_ > const &vertex_ ) const;
+		void set_in_queue( Vertex< Kernel_ > const &vertex_, bool value_ );
+
+		bool is_in_tree( Vertex< Kernel_ > const &vertex_ ) const;
+		void set_in_tree( Vertex< Kernel_ > const &vertex_ );
+
+		bool is_in_tree( Edge< Kernel_ > const &edge_ ) const;
+		void set_in_tree( Edge< Kernel_ > const &edge_ );
+
+		double canonical_loop_length( Edge< Kernel_ > const &edge_ ) const;
+		void set_canonical_loop_length( Edge< Kernel_ > const &edge_,
+			double canonical_loop_length_ );
+
+		// ( canonical loop length, edge index ) of the edges off the tree
+		// closing a loop of finite length; ordered, they give the order in
+		// which candidates are considered
+		std::vector< std::pair< double, unsigned > > &candidates();
+
+		// Resets the tree to an empty one; only the vertices and edges
+		// touched since the last reset are visited
+		void clear();
+
+		// Records that the state of the vertex or edge is to be reset
+		void touch_vertex( unsigned index_ );
+		void touch_edge( unsigned index_ );
+
+		// Indices of the vertices touched since the last reset; the
+		// vertices of the tree are among them
+		std::vector< unsigned > const &touched_vertices() const;
+
+		// Dijkstra queue of the vertices reached but not in the tree yet
+		Headers::Dary_heap &queue();
+
+	private:
+
+		enum
+		{
+			IS_IN_QUEUE = 1,
+			IS_IN_TREE = 1 << 1,
+			IS_TOUCHED = 1 << 2
+		};
+
+		// Distance to the root
+		std::vector< double > m_distances_to_root;
+
+		// The path to the root in the contracted complex is not stored; it
+		// is the sum of the images of the edges to the parents on the way,
+		// most of which are empty. These skip over the empty ones
+		std::vector< Vertex< Kernel_ > * > m_image_ancestors;
+		std::vector< unsigned > m_image_depths;
+
+		// Edge connecting a vertex to its parent; 0 for the root
+		std::vector< Edge< Kernel_ > * > m_edges_to_parent;
+
+		std::vector< unsigned char > m_vertex_flags;
+		std::vector< unsigned char > m_edge_flags;
+
+		// Length of the canonical loop of an edge; canonical loop is formed
+		// by the edge and two chains connecting the endpoints of the edge
+		// to the root of the tree
+		std::vector< double > m_canonical_loop_lengths;
+
+		std::vector< std::pair< double, unsigned > > m_candidates;
+
+		// Dijkstra queue of the vertices reached but not in the tree yet
+		Headers::Dary_heap m_queue;
+
+		// Indices of the vertices and edges with IS_TOUCHED set
+		std::vector< unsigned > m_touched_vertices;
+		std::vector< unsigned > m_touched_edges;
+	};
+
 	///////////////////////////////////////////////////////////////////////////
 	//
 	// Represents a simplicial complex.
@@ -322,6 +401,18 @@ namespace trackLoop
 		void contract_if_needed( Edge< Kernel_ > &edge_ );
 		void contract_if_needed( Triangle< Kernel_ > &triangle_ );
 
+		// Inserts a simplex and contracts it right away, so that the
+		// contracted complex grows together with the filtration; missing
+		// edges are created, existing ones are left untouched
+		void insert_edge( Vertex< Kernel_ > &a_, Vertex< Kernel_ > &b_,
+			double length );
+		void insert_triangle( Vertex< Kernel_ > &a_,
+			Vertex< Kernel_ > &b_, Vertex< Kernel_ > &c_ );
+
+		// Brings the edge images and the basis numbering up to date after
+		// incremental insertions and drops the loops of the previous query
+		void update_contraction();
+
 		void sample( double coefficient_ );
 
 		// returns the shortest path to each node from the node "src"
@@ -332,6 +423,26 @@ namespace trackLoop
 		Basis_loop< Kernel_ > &basis_loop_at( unsigned i_ );
 		void compute_basis();
 
+		// Number of threads computing canonical loops in compute_basis()
+		unsigned number_of_threads() const;
+		void set_number_of_threads( unsigned number_of_threads_ );
+
+		// Returns the edge connecting the vertices, or 0 if there is none
+		Edge< Kernel_ > *find_edge( Vertex< Kernel_ > &a_, Vertex< Kernel_ > &b_ );
+
+		// Returns the class of a cycle in the contracted complex in terms
+		// of basis loops; requires an up to date contraction
+		boost::dynamic_bitset<> homology_class(
+			std::vector< Edge< Kernel_ > * > const &edges_ ) const;
+
+		// Returns the shortest loop through the edge whose class is
+		// independent of the given classes, or 0 if there is none. Unlike
+		// compute_basis(), only the neighbourhood of the edge is searched
+		// when the loop closed by the shortest path between its endpoints
+		// is good enough. The caller owns the loop.
+		Basis_loop< Kernel_ > *shortest_nontrivial_loop_through(
+			Edge< Kernel_ > &edge_, Headers::Z2_basis &alive_classes_ );
+
 	public:		
 
 		// If the edge survives in the contracted complex, e2b returns
@@ -339,10 +450,48 @@ namespace trackLoop
 		// otherwise, e2b returns -1
 		unsigned e2b( unsigned edge_index_ ) const;
 
-		void compute_canonical_loops_for( Vertex< Kernel_ > &vertex_ );
-		void compute_canonical_loop_lengths();
-		void compute_shortest_path_tree_for( Vertex< Kernel_ > &vertex_ );
-		void clear_shortest_path_tree();
+		// Expands the image of the edge until it consists of basis edges
+		// only; returns true if the edge is itself a basis edge
+		bool compute_image( Edge< Kernel_ > &edge_ );
+
+		// Computes canonical loops for every stride_-th source starting from
+		// first_; the loops of the i-th source go to canonical_loops_[ i ].
+		// Only the given lists are written, so calls with different first_
+		// may run in parallel
+		void compute_canonical_loops_for( std::vector< Vertex< Kernel_ > * >
+			const &sources_, unsigned first_, unsigned stride_,
+			std::vector< std::vector< Canonical_loop< Kernel_ > * > >
+			&canonical_loops_ );
+		void compute_canonical_loops_for( Vertex< Kernel_ > &vertex_,
+			Shortest_path_tree< Kernel_ > &tree_,
+			std::vector< Canonical_loop< Kernel_ > * > &canonical_loops_ );
+		void compute_canonical_loop_lengths( Shortest_path_tree< Kernel_ > &tree_ );
+		// Grows the tree from the vertex without using the excluded edge;
+		// stops as soon as the target is reached, if there is one, or
+		// before a vertex farther than the radius joins the tree. Returns
+		// true if the tree spans the component of the vertex
+		bool compute_shortest_path_tree_for( Vertex< Kernel_ > &vertex_,
+			Shortest_path_tree< Kernel_ > &tree_,
+			Edge< Kernel_ > const *p_excluded_edge_ = 0,
+			Vertex< Kernel_ > const *p_target_ = 0,
+			double radius_ = INFINITY );
+
+		// Appends the edges of the tree path from the vertex to the root
+		void append_path_to_root( Vertex< Kernel_ > &vertex_,
+			Shortest_path_tree< Kernel_ > const &tree_,
+			std::vector< Edge< Kernel_ > * > &chain_ ) const;
+
+		// Adds the tree path between the vertices, taken in the contracted
+		// complex, to the bits; only the edges with a nonempty image below
+		// the lowest common ancestor are visited
+		void add_contracted_path( Vertex< Kernel_ > const &a_,
+			Vertex< Kernel_ > const &b_,
+			Shortest_path_tree< Kernel_ > const &tree_,
+			boost::dynamic_bitset<> &bits_ ) const;
+
+		// Creates a loop from a closed chain; edges occurring twice cancel
+		Basis_loop< Kernel_ > *create_loop(
+			std::vector< Edge< Kernel_ > * > const &chain_ );
 		
 	public:
 
@@ -356,12 +505,22 @@ namespace trackLoop
 		typedef boost::unordered_map< VV, Edge< Kernel_ > * > VV2E;
 		VV2E m_vv2e;
 
-		unsigned m_tree_size;
-		
+		unsigned m_number_of_threads;
+
 		std::vector< unsigned > m_e2b;
 		std::vector< Canonical_loop< Kernel_ > * > m_canonical_loops;
 		std::vector< Basis_loop< Kernel_ > * > m_basis_loops;
 
+		// Trees of shortest_nontrivial_loop_through(), kept between calls
+		// so that their arrays are allocated once
+		Shortest_path_tree< Kernel_ > m_a_tree;
+		Shortest_path_tree< Kernel_ > m_b_tree;
+
+		// Length of the longest loop in some basis made of the canonical
+		// loops computed so far; no longer loop enters the shortest basis
+		double m_loop_length_bound;
+		boost::mutex m_loop_length_bound_mutex;
+
 		boost::timer m_timer;
 		boost::progress_display *m_p_progress;
 
@@ -377,8 +536,7 @@ namespace trackLoop
 	template< typename Kernel_ >
 	inline
 	Vertex< Kernel_ >::Vertex( Point const &location_ )
-		: m_location( location_ ), m_distance_to_root( 0 ),
-		m_p_edge_to_parent( 0 )
+		: m_location( location_ )
 	{
 		// Initially, the image of each vertex is the vertex itself
 		m_p_image = this;
@@ -388,8 +546,6 @@ namespace trackLoop
 	inline
 	Vertex< Kernel_ >::Vertex()
 	{
-		m_distance_to_root = 0;
-		m_p_edge_to_parent = 0;
 		// Initially, the image of each vertex is the vertex itself
 		m_p_image = this;
 	}
@@ -429,89 +585,6 @@ namespace trackLoop
 		return &edge_.a() == this ? edge_.b() : edge_.a();
 	}
 
-	template< typename Kernel_ >
-	inline double
-	Vertex< Kernel_ >::distance_to_root() const
-	{
-		return m_distance_to_root;
-	}
-
-	template< typename Kernel_ >
-	inline void
-	Vertex< Kernel_ >::set_distance_to_root( double distance_to_root_ )
-	{
-		m_distance_to_root = distance_to_root_;
-	}
-
-	template< typename Kernel_ >
-	inline boost::dynamic_bitset<> const &
-	Vertex< Kernel_ >::contracted_path_to_root() const
-	{
-		return m_contracted_path_to_root;
-	}
-
-	template< typename Kernel_ >
-	inline boost::dynamic_bitset<> &
-	Vertex< Kernel_ >::contracted_path_to_root()
-	{
-		return m_contracted_path_to_root;
-	}
-
-	template< typename Kernel_ >
-	inline bool
-	Vertex< Kernel_ >::has_parent() const
-	{
-		return m_p_edge_to_parent != 0;
-	}
-
-	template< typename Kernel_ >
-	inline Vertex< Kernel_ > const & 
-	Vertex< Kernel_ >::parent() const
-	{
-		if ( &edge_to_parent().a() == this )
-			return edge_to_parent().b();
-		else
-			return edge_to_parent().a();
-	}
-
-	template< typename Kernel_ >
-	inline Vertex< Kernel_ > & 
-	Vertex< Kernel_ >::parent()
-	{
-		if ( &edge_to_parent().a() == this )
-			return edge_to_parent().b();
-		else
-			return edge_to_parent().a();
-	}
-
-	template< typename Kernel_ >
-	inline Edge< Kernel_ > const &
-	Vertex< Kernel_ >::edge_to_parent() const
-	{
-		return *m_p_edge_to_parent;
-	}
-
-	template< typename Kernel_ >
-	inline Edge< Kernel_ > &
-	Vertex< Kernel_ >::edge_to_parent()
-	{
-		return *m_p_edge_to_parent;
-	}
-
-	template< typename Kernel_ >
-	inline void
-	Vertex< Kernel_ >::set_edge_to_parent( Edge< Kernel_ > &edge_to_parent_ )
-	{
-		m_p_edge_to_parent = &edge_to_parent_;
-	}
-
-	template< typename Kernel_ >
-	inline void
-	Vertex< Kernel_ >::clear_edge_to_parent()
-	{
-		m_p_edge_to_parent = 0;
-	}
-
 	template< typename Kernel_ >
 	inline Vertex< Kernel_ > const &
 	Vertex< Kernel_ >::image() const
@@ -536,7 +609,7 @@ namespace trackLoop
 	template< typename Kernel_ >
 	inline
 	Edge< Kernel_ >::Edge( Vertex< Kernel_ > &a_, Vertex< Kernel_ > &b_, double length)
-		: m_a( a_ ), m_b( b_ ), m_length(length), m_canonical_loop_length( INFINITY )
+		: m_a( a_ ), m_b( b_ ), m_length(length)
 	{ 
 		// Initially, the image of each edge is the edge itself
 		m_image.push_back( this );
@@ -577,21 +650,6 @@ namespace trackLoop
 		return m_length;
 	}
 
-	template< typename Kernel_ >
-	inline double
-	Edge< Kernel_ >::canonical_loop_length() const
-	{
-		return m_canonical_loop_length;
-	}
-
-	template< typename Kernel_ >
-	inline void
-	Edge< Kernel_ >::set_canonical_loop_length(
-		double canonical_loop_length_ )
-	{
-		m_canonical_loop_length = canonical_loop_length_;
-	}
-
 	template< typename Kernel_ >
 	inline std::vector< Edge< Kernel_ > * > const &
 	Edge< Kernel_ >::image() const
@@ -659,10 +717,11 @@ namespace trackLoop
 	template< typename Kernel_ >
 	inline
 	Canonical_loop< Kernel_ >::Canonical_loop( Vertex< Kernel_ > &vertex_,
-		Edge< Kernel_ > &edge_, boost::dynamic_bitset<> const &bits_ )
+		Edge< Kernel_ > &edge_, boost::dynamic_bitset<> const &bits_,
+		double length_ )
 		: m_vertex( vertex_ ), m_edge( edge_ ), m_bits( bits_ )
 	{
-		set_norm( edge_.canonical_loop_length() );
+		set_norm( length_ );
 	}
 
 	template< typename Kernel_ >
@@ -751,169 +810,409 @@ namespace trackLoop
 	}
 
 	template< typename Kernel_ >
-	inline
-	Complex< Kernel_ >::Complex( int dimensions, bool verbose_ )
-		: num_dimensions(dimensions), m_verbose( verbose_ ), m_tree_size( 0 ), m_p_progress( 0 ),
-		m_expanded( false )
+	inline void
+	Shortest_path_tree< Kernel_ >::resize( unsigned number_of_vertices_,
+		unsigned number_of_edges_ )
 	{
-		// resize our lower and upper bound vectors
-		lower_bound.resize(dimensions);
-		upper_bound.resize(dimensions);
+		clear();
+
+		m_distances_to_root.resize( number_of_vertices_, INFINITY );
+		m_image_ancestors.resize( number_of_vertices_, 0 );
+		m_image_depths.resize( number_of_vertices_, 0 );
+		m_edges_to_parent.resize( number_of_vertices_, 0 );
+		m_vertex_flags.resize( number_of_vertices_, 0 );
+
+		m_edge_flags.resize( number_of_edges_, 0 );
+		m_canonical_loop_lengths.resize( number_of_edges_, INFINITY );
+		m_candidates.reserve( number_of_edges_ );
+
+		m_queue.resize( number_of_vertices_ );
 	}
 
-	// This is the constructor for matrix format
 	template< typename Kernel_ >
-	inline
-	Complex< Kernel_ >::Complex( bool verbose_)
-		: m_verbose( verbose_ ), m_tree_size( 0 ), m_p_progress( 0 ),
-		m_expanded( false )
+	inline double
+	Shortest_path_tree< Kernel_ >::distance_to_root(
+		Vertex< Kernel_ > const &vertex_ ) const
 	{
+		return m_distances_to_root[ vertex_.index() ];
 	}
 
 	template< typename Kernel_ >
-	inline
-	Complex< Kernel_ >::~Complex()
+	inline void
+	Shortest_path_tree< Kernel_ >::set_distance_to_root(
+		Vertex< Kernel_ > const &vertex_, double distance_to_root_ )
 	{
-		using namespace std;
-		using namespace boost;
-
-		if ( m_verbose )
-		{
-			cout << endl;
-			cout << "Destroying simplicial complex..." << flush;
-			m_timer.restart();
-		}
-
-		for_each( m_vertices.begin(), m_vertices.end(),
-			checked_delete< Vertex< Kernel_ > > );
-
-		for_each( m_edges.begin(), m_edges.end(),
-			checked_delete< Edge< Kernel_ > > );
-		for_each( m_triangles.begin(), m_triangles.end(),
-			checked_delete< Triangle< Kernel_ > > );
-		for_each( m_canonical_loops.begin(), m_canonical_loops.end(),
-			checked_delete< Canonical_loop< Kernel_ > > );
-		for_each( m_basis_loops.begin(), m_basis_loops.end(),
-			checked_delete< Basis_loop< Kernel_ > > );
+		touch_vertex( vertex_.index() );
+		m_distances_to_root[ vertex_.index() ] = distance_to_root_;
+	}
 
-		if ( m_verbose )
-			cout << "done in " << m_timer.elapsed() << "s" << endl;
+	template< typename Kernel_ >
+	inline Vertex< Kernel_ > *
+	Shortest_path_tree< Kernel_ >::image_ancestor(
+		Vertex< Kernel_ > const &vertex_ ) const
+	{
+		return m_image_ancestors[ vertex_.index() ];
 	}
 
 	template< typename Kernel_ >
 	inline unsigned
-	Complex< Kernel_ >::number_of_vertices() const
+	Shortest_path_tree< Kernel_ >::image_depth(
+		Vertex< Kernel_ > const &vertex_ ) const
 	{
-		return m_vertices.size();
+		return m_image_depths[ vertex_.index() ];
 	}
 
 	template< typename Kernel_ >
-	inline Vertex< Kernel_ > &
-	Complex< Kernel_ >::vertex_at( unsigned i_ )
+	inline void
+	Shortest_path_tree< Kernel_ >::set_image_ancestor(
+		Vertex< Kernel_ > const &vertex_, Vertex< Kernel_ > *p_image_ancestor_,
+		unsigned image_depth_ )
 	{
-		return *m_vertices.at( i_ );
+		touch_vertex( vertex_.index() );
+		m_image_ancestors[ vertex_.index() ] = p_image_ancestor_;
+		m_image_depths[ vertex_.index() ] = image_depth_;
 	}
 
-
-	// inserts the vertix into the complex.
 	template< typename Kernel_ >
-	inline void
-	Complex< Kernel_ >::insert_vertex( Vertex< Kernel_ > *p_vertex_)
+	inline bool
+	Shortest_path_tree< Kernel_ >::has_parent(
+		Vertex< Kernel_ > const &vertex_ ) const
 	{
-		if(input_type_flag==0)
-		{
-			int i;
-			// updates the upper and lower bounds for the complex in each dimension
-			if ( number_of_vertices() == 0 )
-			{
-				for(i=0; i<num_dimensions; i++)
-				{
-					lower_bound.at(i) = p_vertex_->location().get_coord(i);
-					upper_bound.at(i) = p_vertex_->location().get_coord(i);
-				}
-			}
-			else
-			{
-				for(i=0; i<num_dimensions; i++)
-				{
-					if(lower_bound.at(i) > p_vertex_->location().get_coord(i))
-						lower_bound.at(i) = p_vertex_->location().get_coord(i);
-					else if(upper_bound.at(i) < p_vertex_->location().get_coord(i))
-						upper_bound.at(i) = p_vertex_->location().get_coord(i);
-				}
-			}
-		}
-		p_vertex_->set_index( m_vertices.size() );
-		m_vertices.push_back( p_vertex_ );
+		return m_edges_to_parent[ vertex_.index() ] != 0;
 	}
 
 	template< typename Kernel_ >
-	inline unsigned
-	Complex< Kernel_ >::number_of_edges() const
+	inline Vertex< Kernel_ > &
+	Shortest_path_tree< Kernel_ >::parent(
+		Vertex< Kernel_ > const &vertex_ ) const
 	{
-		return m_edges.size();
+		Edge< Kernel_ > &edge( edge_to_parent( vertex_ ) );
+		return &edge.a() == &vertex_ ? edge.b() : edge.a();
 	}
 
 	template< typename Kernel_ >
 	inline Edge< Kernel_ > &
-	Complex< Kernel_ >::edge_at( unsigned i_ )
+	Shortest_path_tree< Kernel_ >::edge_to_parent(
+		Vertex< Kernel_ > const &vertex_ ) const
 	{
-		return *m_edges.at( i_ );
+		return *m_edges_to_parent[ vertex_.index() ];
 	}
 
 	template< typename Kernel_ >
 	inline void
-	Complex< Kernel_ >::create_edge( Vertex< Kernel_ > &a_,
-		Vertex< Kernel_ > &b_, double length)
+	Shortest_path_tree< Kernel_ >::set_edge_to_parent(
+		Vertex< Kernel_ > const &vertex_, Edge< Kernel_ > &edge_to_parent_ )
 	{
-		Edge< Kernel_ > *p_ab( new Edge< Kernel_ >( a_, b_, length) );
-		p_ab->set_index( number_of_edges() );
-		
-		a_.coboundary().push_back( p_ab );
-		b_.coboundary().push_back( p_ab );
+		touch_vertex( vertex_.index() );
+		m_edges_to_parent[ vertex_.index() ] = &edge_to_parent_;
+	}
 
-		VV ab_key = std::make_pair( std::min( &a_, &b_ ), std::max( &a_, &b_ ) );
-		// m_vv2e is an unordered map.  A pair of vertices get mapped to an edge.
-		m_vv2e.insert( std::make_pair( ab_key, p_ab ) );
-		m_edges.push_back( p_ab );
+	template< typename Kernel_ >
+	inline bool
+	Shortest_path_tree< Kernel_ >::is_in_queue(
+		Vertex< Kernel_ > const &vertex_ ) const
+	{
+		return m_vertex_flags[ vertex_.index() ] & IS_IN_QUEUE;
 	}
 
 	template< typename Kernel_ >
-	inline unsigned
-	Complex< Kernel_ >::number_of_triangles() const
+	inline void
+	Shortest_path_tree< Kernel_ >::set_in_queue(
+		Vertex< Kernel_ > const &vertex_, bool value_ )
 	{
-		return m_triangles.size();
+		touch_vertex( vertex_.index() );
+		if ( value_ )
+			m_vertex_flags[ vertex_.index() ] |= IS_IN_QUEUE;
+		else
+			m_vertex_flags[ vertex_.index() ] &= ~IS_IN_QUEUE;
 	}
 
 	template< typename Kernel_ >
-	inline Triangle< Kernel_ > &
-	Complex< Kernel_ >::triangle_at( unsigned i_ )
+	inline bool
+	Shortest_path_tree< Kernel_ >::is_in_tree(
+		Vertex< Kernel_ > const &vertex_ ) const
 	{
-		return *m_triangles.at( i_ );
+		return m_vertex_flags[ vertex_.index() ] & IS_IN_TREE;
 	}
 
 	template< typename Kernel_ >
 	inline void
-	Complex< Kernel_ >::create_triangle( Vertex< Kernel_ > &a_,
-		Vertex< Kernel_ > &b_, Vertex< Kernel_ > &c_ )
+	Shortest_path_tree< Kernel_ >::set_in_tree(
+		Vertex< Kernel_ > const &vertex_ )
 	{
-		VV ab_key( std::min( &a_, &b_ ), std::max( &a_, &b_ ) );
-		VV ac_key( std::min( &a_, &c_ ), std::max( &a_, &c_ ) );
-		VV bc_key( std::min( &b_, &c_ ), std::max( &b_, &c_ ) );
-
-		// if edges of the triangle do not exist, create them
-		if ( m_vv2e.find( ab_key ) == m_vv2e.end() )
-			create_edge( a_, b_, sqrt(a_.location().get_squared_distance_to(b_.location())));
-		if ( m_vv2e.find( ac_key ) == m_vv2e.end() )
-			create_edge( a_, c_, sqrt(a_.location().get_squared_distance_to(c_.location())));
-		if ( m_vv2e.find( bc_key ) == m_vv2e.end() )
-			create_edge( b_, c_, sqrt(b_.location().get_squared_distance_to(c_.location())));
-
-		Edge< Kernel_ > &ab( *m_vv2e[ ab_key ] );
-		Edge< Kernel_ > &ac( *m_vv2e[ ac_key ] );
-		Edge< Kernel_ > &bc( *m_vv2e[ bc_key ] );
+		touch_vertex( vertex_.index() );
+		m_vertex_flags[ vertex_.index() ] |= IS_IN_TREE;
+	}
 
-		m_triangles.push_back( new Triangle< Kernel_ >( ab, ac, bc ) );
+	template< typename Kernel_ >
+	inline bool
+	Shortest_path_tree< Kernel_ >::is_in_tree(
+		Edge< Kernel_ > const &edge_ ) const
+	{
+		return m_edge_flags[ edge_.index() ] & IS_IN_TREE;
+	}
+
+	template< typename Kernel_ >
+	inline void
+	Shortest_path_tree< Kernel_ >::set_in_tree( Edge< Kernel_ > const &edge_ )
+	{
+		touch_edge( edge_.index() );
+		m_edge_flags[ edge_.index() ] |= IS_IN_TREE;
+	}
+
+	template< typename Kernel_ >
+	inline double
+	Shortest_path_tree< Kernel_ >::canonical_loop_length(
+		Edge< Kernel_ > const &edge_ ) const
+	{
+		return m_canonical_loop_lengths[ edge_.index() ];
+	}
+
+	template< typename Kernel_ >
+	inline void
+	Shortest_path_tree< Kernel_ >::set_canonical_loop_length(
+		Edge< Kernel_ > const &edge_, double canonical_loop_length_ )
+	{
+		touch_edge( edge_.index() );
+		m_canonical_loop_lengths[ edge_.index() ] = canonical_loop_length_;
+	}
+
+	template< typename Kernel_ >
+	inline std::vector< std::pair< double, unsigned > > &
+	Shortest_path_tree< Kernel_ >::candidates()
+	{
+		return m_candidates;
+	}
+
+	template< typename Kernel_ >
+	inline void
+	Shortest_path_tree< Kernel_ >::clear()
+	{
+		for ( unsigned i( 0 ); i != m_touched_vertices.size(); ++i )
+		{
+			unsigned index( m_touched_vertices[ i ] );
+
+			m_distances_to_root[ index ] = INFINITY;
+			m_edges_to_parent[ index ] = 0;
+			m_vertex_flags[ index ] = 0;
+			m_image_ancestors[ index ] = 0;
+			m_image_depths[ index ] = 0;
+		}
+		m_touched_vertices.clear();
+
+		for ( unsigned i( 0 ); i != m_touched_edges.size(); ++i )
+		{
+			unsigned index( m_touched_edges[ i ] );
+
+			m_edge_flags[ index ] = 0;
+			m_canonical_loop_lengths[ index ] = INFINITY;
+		}
+		m_touched_edges.clear();
+
+		m_candidates.clear();
+		m_queue.clear();
+	}
+
+	template< typename Kernel_ >
+	inline void
+	Shortest_path_tree< Kernel_ >::touch_vertex( unsigned index_ )
+	{
+		if ( !( m_vertex_flags[ index_ ] & IS_TOUCHED ) )
+		{
+			m_vertex_flags[ index_ ] |= IS_TOUCHED;
+			m_touched_vertices.push_back( index_ );
+		}
+	}
+
+	template< typename Kernel_ >
+	inline void
+	Shortest_path_tree< Kernel_ >::touch_edge( unsigned index_ )
+	{
+		if ( !( m_edge_flags[ index_ ] & IS_TOUCHED ) )
+		{
+			m_edge_flags[ index_ ] |= IS_TOUCHED;
+			m_touched_edges.push_back( index_ );
+		}
+	}
+
+	template< typename Kernel_ >
+	inline std::vector< unsigned > const &
+	Shortest_path_tree< Kernel_ >::touched_vertices() const
+	{
+		return m_touched_vertices;
+	}
+
+	template< typename Kernel_ >
+	inline Headers::Dary_heap &
+	Shortest_path_tree< Kernel_ >::queue()
+	{
+		return m_queue;
+	}
+
+	template< typename Kernel_ >
+	inline
+	Complex< Kernel_ >::Complex( int dimensions, bool verbose_ )
+		: num_dimensions(dimensions), m_verbose( verbose_ ), m_number_of_threads( 1 ),
+		m_loop_length_bound( INFINITY ), m_p_progress( 0 ), m_expanded( false )
+	{
+		// resize our lower and upper bound vectors
+		lower_bound.resize(dimensions);
+		upper_bound.resize(dimensions);
+	}
+
+	// This is the constructor for matrix format
+	template< typename Kernel_ >
+	inline
+	Complex< Kernel_ >::Complex( bool verbose_)
+		: m_verbose( verbose_ ), m_number_of_threads( 1 ),
+		m_loop_length_bound( INFINITY ), m_p_progress( 0 ), m_expanded( false )
+	{
+	}
+
+	template< typename Kernel_ >
+	inline
+	Complex< Kernel_ >::~Complex()
+	{
+		using namespace std;
+		using namespace boost;
+
+		if ( m_verbose )
+		{
+			cout << endl;
+			cout << "Destroying simplicial complex..." << flush;
+			m_timer.restart();
+		}
+
+		for_each( m_vertices.begin(), m_vertices.end(),
+			checked_delete< Vertex< Kernel_ > > );
+
+		for_each( m_edges.begin(), m_edges.end(),
+			checked_delete< Edge< Kernel_ > > );
+		for_each( m_triangles.begin(), m_triangles.end(),
+			checked_delete< Triangle< Kernel_ > > );
+		for_each( m_canonical_loops.begin(), m_canonical_loops.end(),
+			checked_delete< Canonical_loop< Kernel_ > > );
+		for_each( m_basis_loops.begin(), m_basis_loops.end(),
+			checked_delete< Basis_loop< Kernel_ > > );
+
+		if ( m_verbose )
+			cout << "done in " << m_timer.elapsed() << "s" << endl;
+	}
+
+	template< typename Kernel_ >
+	inline unsigned
+	Complex< Kernel_ >::number_of_vertices() const
+	{
+		return m_vertices.size();
+	}
+
+	template< typename Kernel_ >
+	inline Vertex< Kernel_ > &
+	Complex< Kernel_ >::vertex_at( unsigned i_ )
+	{
+		return *m_vertices.at( i_ );
+	}
+
+
+	// inserts the vertix into the complex.
+	template< typename Kernel_ >
+	inline void
+	Complex< Kernel_ >::insert_vertex( Vertex< Kernel_ > *p_vertex_)
+	{
+		if(input_type_flag==0)
+		{
+			int i;
+			// updates the upper and lower bounds for the complex in each dimension
+			if ( number_of_vertices() == 0 )
+			{
+				for(i=0; i<num_dimensions; i++)
+				{
+					lower_bound.at(i) = p_vertex_->location().get_coord(i);
+					upper_bound.at(i) = p_vertex_->location().get_coord(i);
+				}
+			}
+			else
+			{
+				for(i=0; i<num_dimensions; i++)
+				{
+					if(lower_bound.at(i) > p_vertex_->location().get_coord(i))
+						lower_bound.at(i) = p_vertex_->location().get_coord(i);
+					else if(upper_bound.at(i) < p_vertex_->location().get_coord(i))
+						upper_bound.at(i) = p_vertex_->location().get_coord(i);
+				}
+			}
+		}
+		p_vertex_->set_index( m_vertices.size() );
+		m_vertices.push_back( p_vertex_ );
+	}
+
+	template< typename Kernel_ >
+	inline unsigned
+	Complex< Kernel_ >::number_of_edges() const
+	{
+		return m_edges.size();
+	}
+
+	template< typename Kernel_ >
+	inline Edge< Kernel_ > &
+	Complex< Kernel_ >::edge_at( unsigned i_ )
+	{
+		return *m_edges.at( i_ );
+	}
+
+	template< typename Kernel_ >
+	inline void
+	Complex< Kernel_ >::create_edge( Vertex< Kernel_ > &a_,
+		Vertex< Kernel_ > &b_, double length)
+	{
+		Edge< Kernel_ > *p_ab( new Edge< Kernel_ >( a_, b_, length) );
+		p_ab->set_index( number_of_edges() );
+		
+		a_.coboundary().push_back( p_ab );
+		b_.coboundary().push_back( p_ab );
+
+		VV ab_key = std::make_pair( std::min( &a_, &b_ ), std::max( &a_, &b_ ) );
+		// m_vv2e is an unordered map.  A pair of vertices get mapped to an edge.
+		m_vv2e.insert( std::make_pair( ab_key, p_ab ) );
+		m_edges.push_back( p_ab );
+	}
+
+	template< typename Kernel_ >
+	inline unsigned
+	Complex< Kernel_ >::number_of_triangles() const
+	{
+		return m_triangles.size();
+	}
+
+	template< typename Kernel_ >
+	inline Triangle< Kernel_ > &
+	Complex< Kernel_ >::triangle_at( unsigned i_ )
+	{
+		return *m_triangles.at( i_ );
+	}
+
+	template< typename Kernel_ >
+	inline void
+	Complex< Kernel_ >::create_triangle( Vertex< Kernel_ > &a_,
+		Vertex< Kernel_ > &b_, Vertex< Kernel_ > &c_ )
+	{
+		VV ab_key( std::min( &a_, &b_ ), std::max( &a_, &b_ ) );
+		VV ac_key( std::min( &a_, &c_ ), std::max( &a_, &c_ ) );
+		VV bc_key( std::min( &b_, &c_ ), std::max( &b_, &c_ ) );
+
+		// if edges of the triangle do not exist, create them
+		if ( m_vv2e.find( ab_key ) == m_vv2e.end() )
+			create_edge( a_, b_, sqrt(a_.location().get_squared_distance_to(b_.location())));
+		if ( m_vv2e.find( ac_key ) == m_vv2e.end() )
+			create_edge( a_, c_, sqrt(a_.location().get_squared_distance_to(c_.location())));
+		if ( m_vv2e.find( bc_key ) == m_vv2e.end() )
+			create_edge( b_, c_, sqrt(b_.location().get_squared_distance_to(c_.location())));
+
+		Edge< Kernel_ > &ab( *m_vv2e[ ab_key ] );
+		Edge< Kernel_ > &ac( *m_vv2e[ ac_key ] );
+		Edge< Kernel_ > &bc( *m_vv2e[ bc_key ] );
+
+		m_triangles.push_back( new Triangle< Kernel_ >( ab, ac, bc ) );
 	}
 
 	template< typename Kernel_ >
@@ -931,6 +1230,10 @@ namespace trackLoop
 			m_timer.restart();
 		}
 
+		// the complex may have been sampled before an incremental update
+		for ( unsigned i( 0 ); i < number_of_vertices(); ++i )
+			vertex_at( i ).clear_flag( Vertex< Kernel_ >::IS_IN_SAMPLE );
+
 		if ( coefficient_ == 1 )
 		{
 			// every vertex should be in the sample
@@ -1443,40 +1746,7 @@ namespace trackLoop
 		// For each edge, we compute its image in the contracted complex
 		for ( unsigned i( 0 ); i != number_of_edges(); ++i )
 		{
-			vector< Edge< Kernel_ > * > new_image;			
-			
-			deque< Edge< Kernel_ > * > edges;
-			edges.push_back( &edge_at( i ) );
-
-			while ( !edges.empty() )
-			{
-				Edge< Kernel_ > &edge( *edges.front() );
-				edges.pop_front();
-				
-				vector< Edge< Kernel_ > * > &image( edge.image() );
-				if ( image.empty() )
-					continue;
-
-				if ( image.size() == 1 && image.front() == &edge )
-				{
-					vector< Edge< Kernel_ > * > edge_chain( 1, &edge );
-					vector< Edge< Kernel_ > * > buffer;
-					set_symmetric_difference( new_image.begin(),
-						new_image.end(), edge_chain.begin(),
-						edge_chain.end(), back_inserter( buffer ),
-						pointee_index_is_less );
-					swap( new_image, buffer );
-
-					continue;
-				}
-
-				copy ( image.begin(), image.end(), back_inserter( edges ) );
-			}
-
-			edge_at( i ).image() = new_image;
-
-			// basis edge is mapped to itself
-			if ( new_image.size() == 1 && new_image.front() == &edge_at( i ) )
+			if ( compute_image( edge_at( i ) ) )
 				m_e2b.at( i ) = basis_size++;
 
 			if ( m_verbose )
@@ -1508,44 +1778,174 @@ namespace trackLoop
 	}
 
 	template< typename Kernel_ >
-	inline unsigned
-	Complex< Kernel_ >::e2b( unsigned edge_index_ ) const
+	inline bool
+	Complex< Kernel_ >::compute_image( Edge< Kernel_ > &edge_ )
 	{
-		return m_e2b.at( edge_index_ );
-	}
+		using namespace std;
+		using namespace Headers;
 
-	// Prints shortest paths from src to all other vertices using Dijkstra's algorithm
-	template< typename Kernel_ >
-	inline vector<double>
-	Complex< Kernel_ >::shortest_path_graph(int src, double alpha)
-	{
-		// Create a set to store vertices that are being
-		// prerocessed
-		set< pair<double, int> > setds;
+		vector< Edge< Kernel_ > * > &image( edge_.image() );
+
+		// The image is up to date as long as every edge in it is still
+		// mapped to itself; this is the common case after an incremental
+		// update, since a triangle only remaps a single edge
+		bool is_up_to_date( true );
+		for ( unsigned i( 0 ); i != image.size(); ++i )
+		{
+			vector< Edge< Kernel_ > * > const &edge_image( image.at( i )->image() );
+			if ( edge_image.size() != 1 || edge_image.front() != image.at( i ) )
+			{
+				is_up_to_date = false;
+				break;
+			}
+		}
+
+		if ( !is_up_to_date )
+		{
+			vector< Edge< Kernel_ > * > new_image;
+
+			deque< Edge< Kernel_ > * > edges;
+			edges.push_back( &edge_ );
+
+			while ( !edges.empty() )
+			{
+				Edge< Kernel_ > &edge( *edges.front() );
+				edges.pop_front();
+
+				vector< Edge< Kernel_ > * > &edge_image( edge.image() );
+				if ( edge_image.empty() )
+					continue;
+
+				if ( edge_image.size() == 1 && edge_image.front() == &edge )
+				{
+					vector< Edge< Kernel_ > * > edge_chain( 1, &edge );
+					vector< Edge< Kernel_ > * > buffer;
+					set_symmetric_difference( new_image.begin(),
+						new_image.end(), edge_chain.begin(),
+						edge_chain.end(), back_inserter( buffer ),
+						pointee_index_is_less );
+					swap( new_image, buffer );
+
+					continue;
+				}
+
+				copy ( edge_image.begin(), edge_image.end(), back_inserter( edges ) );
+			}
+
+			image = new_image;
+		}
+
+		// basis edge is mapped to itself
+		return image.size() == 1 && image.front() == &edge_;
+	}
+
+	template< typename Kernel_ >
+	inline void
+	Complex< Kernel_ >::insert_edge( Vertex< Kernel_ > &a_,
+		Vertex< Kernel_ > &b_, double length )
+	{
+		VV ab_key( std::min( &a_, &b_ ), std::max( &a_, &b_ ) );
+		if ( m_vv2e.find( ab_key ) != m_vv2e.end() )
+			return;
+
+		create_edge( a_, b_, length );
+		contract_if_needed( *m_vv2e[ ab_key ] );
+	}
+
+	template< typename Kernel_ >
+	inline void
+	Complex< Kernel_ >::insert_triangle( Vertex< Kernel_ > &a_,
+		Vertex< Kernel_ > &b_, Vertex< Kernel_ > &c_ )
+	{
+		insert_edge( a_, b_, sqrt( a_.location().get_squared_distance_to( b_.location() ) ) );
+		insert_edge( a_, c_, sqrt( a_.location().get_squared_distance_to( c_.location() ) ) );
+		insert_edge( b_, c_, sqrt( b_.location().get_squared_distance_to( c_.location() ) ) );
+
+		create_triangle( a_, b_, c_ );
+		contract_if_needed( *m_triangles.back() );
+	}
+
+	template< typename Kernel_ >
+	inline void
+	Complex< Kernel_ >::update_contraction()
+	{
+		using namespace std;
+		using namespace boost;
+
+		if ( m_verbose )
+		{
+			cout << endl;
+			cout << "Updating contracted complex..." << flush;
+			m_timer.restart();
+		}
+
+		// Flatten the vertex images
+		for ( unsigned i( 0 ); i != number_of_vertices(); ++i )
+		{
+			Vertex< Kernel_ > &vertex( vertex_at( i ) );
+
+			Vertex< Kernel_ > *p_image( &vertex.image() );
+			while ( &p_image->image() != p_image )
+				p_image = &p_image->image();
+
+			vertex.set_image( *p_image );
+		}
+
+		m_e2b.assign( number_of_edges(), -1 );
+		unsigned basis_size( 0 );
+
+		for ( unsigned i( 0 ); i != number_of_edges(); ++i )
+		{
+			if ( compute_image( edge_at( i ) ) )
+				m_e2b.at( i ) = basis_size++;
+		}
+
+		for_each( m_canonical_loops.begin(), m_canonical_loops.end(),
+			checked_delete< Canonical_loop< Kernel_ > > );
+		m_canonical_loops.clear();
+
+		for_each( m_basis_loops.begin(), m_basis_loops.end(),
+			checked_delete< Basis_loop< Kernel_ > > );
+		m_basis_loops.assign( basis_size, 0 );
+
+		if ( m_verbose )
+			cout << "done in " << m_timer.elapsed() << "s" << endl;
+	}
+
+	template< typename Kernel_ >
+	inline unsigned
+	Complex< Kernel_ >::e2b( unsigned edge_index_ ) const
+	{
+		return m_e2b.at( edge_index_ );
+	}
+
+	// Prints shortest paths from src to all other vertices using Dijkstra's algorithm
+	template< typename Kernel_ >
+	inline vector<double>
+	Complex< Kernel_ >::shortest_path_graph(int src, double alpha)
+	{
+		// Create a heap to store vertices that are being
+		// prerocessed
+		Headers::Dary_heap heap( m_vertices.size() );
 
 		// Create a vector for distances and initialize all
 		// distances as infinite (INFINITY)
 		vector<double> dist(m_vertices.size(), INFINITY);
 
-		// Insert source itself in Set and initialize its
+		// Insert source itself in heap and initialize its
 		// distance as 0.
-		setds.insert(make_pair(0, src));
+		heap.push(src, 0);
 		dist[src] = 0;
 
 		/* Looping till all shortest distance are finalized
-		then setds will become empty */
-		while (!setds.empty())
+		then heap will become empty */
+		while (!heap.empty())
 		{
-			// The first vertex in Set is the minimum distance
-			// vertex, extract it from set.
-			pair<double, int> tmp = *(setds.begin());
-			setds.erase(setds.begin());
-
-			// vertex label is stored in second of pair (it
-			// has to be done this way to keep the vertices
-			// sorted distance (distance must be first item
-			// in pair)
-			int u = tmp.second;
+			// The top of the heap is the minimum distance
+			// vertex, extract it from heap (ties go to the
+			// smaller label)
+			int u = heap.top();
+			heap.pop();
 
 			// 'i' is used to get all adjacent vertices of a vertex
 			vector< pair<int, double> >::iterator i;
@@ -1563,17 +1963,18 @@ namespace trackLoop
 				if (dist[v] > dist[u] + weight)
 				{
 					/*  If distance of v is not INF then it must be in
-					our set, so removing it and inserting again
-					with updated less distance.  
-					Note : We extract only those vertices from Set
+					our heap, so decreasing its key to the updated
+					less distance.  
+					Note : We extract only those vertices from heap
 					for which distance is finalized. So for them, 
 					we would never reach here.  */
 					if (dist[v] != INFINITY)
-						setds.erase(setds.find(make_pair(dist[v], v)));
+						heap.decrease(v, dist[u] + weight);
+					else
+						heap.push(v, dist[u] + weight);
 
 					// Updating distance of v
 					dist[v] = dist[u] + weight;
-					setds.insert(make_pair(dist[v], v));
 				}
 			}
 		}
@@ -1582,14 +1983,27 @@ namespace trackLoop
 		return dist;
 	}
 	
+	template< typename Kernel_ >
+	inline unsigned
+	Complex< Kernel_ >::number_of_threads() const
+	{
+		return m_number_of_threads;
+	}
+
+	template< typename Kernel_ >
+	inline void
+	Complex< Kernel_ >::set_number_of_threads( unsigned number_of_threads_ )
+	{
+		m_number_of_threads = std::max( number_of_threads_, 1u );
+	}
+
 	template< typename Kernel_ >
 	inline void
 	Complex< Kernel_ >::compute_basis()
 	{
 		using namespace std;
-		using namespace CGAL;
 		using namespace boost;
-		using namespace Headers;						
+		using namespace Headers;
 
 		if ( m_verbose )
 		{
@@ -1600,41 +2014,69 @@ namespace trackLoop
 		if ( basis_rank() == 0 )
 			return;
 
-		// COMPUTES THE SAMPLE SIZE OF THE COMPUTED COMPLEX
-		unsigned sample_size( 0 );
+		// COMPUTES THE SAMPLE OF THE COMPUTED COMPLEX
+		vector< Vertex< Kernel_ > * > sample;
 		for ( unsigned i( 0 ); i != number_of_vertices(); ++i )
 		{
 			if ( vertex_at( i ).has_flag( Vertex< Kernel_ >::IS_IN_SAMPLE ) )
-				++sample_size;
+				sample.push_back( &vertex_at( i ) );
 		}
 
+		unsigned sample_size( sample.size() );
+
+		unsigned number_of_threads( std::min( m_number_of_threads,
+			std::max( sample_size, 1u ) ) );
+
 		if ( m_verbose )
 		{
 			cout << endl;
-			cout << "Computing canonical loops..." << flush;
+			cout << "Computing canonical loops";
+			if ( number_of_threads > 1 )
+				cout << " in " << number_of_threads << " threads";
+			cout << "..." << flush;
 
 			m_p_progress = new progress_display( sample_size );
 			m_timer.restart();
-		}		
+		}
 
 		// we can have at most Vb_2 canonical loops (less if >1 components)
 		cout<<"compute basis: "<<basis_rank()<<"\n";
 
-		m_canonical_loops.reserve( sample_size * basis_rank() );
+		// Sources are independent; every thread grows its own shortest path
+		// trees and the loops are merged in the order of the sources, so
+		// the result does not depend on the number of threads
+		vector< vector< Canonical_loop< Kernel_ > * > > canonical_loops( sample_size );
 
-		for ( unsigned i( 0 ); i != number_of_vertices(); ++i )
-				vertex_at( i ).contracted_path_to_root().resize( basis_rank() );
+		m_loop_length_bound = INFINITY;
 
-		for ( unsigned i( 0 ); i != number_of_vertices(); ++i )
+		if ( number_of_threads == 1 )
+			compute_canonical_loops_for( sample, 0, 1, canonical_loops );
+		else
 		{
-			Vertex< Kernel_ > &vertex( vertex_at( i ) );	
-			if ( !vertex.has_flag( Vertex< Kernel_ >::IS_IN_SAMPLE ) )
-				continue;
-			
-			compute_canonical_loops_for( vertex );
+			thread_group threads;
+			for ( unsigned i( 0 ); i != number_of_threads; ++i )
+			{
+				threads.create_thread( boost::bind(
+					static_cast< void ( Complex< Kernel_ >::* )(
+					vector< Vertex< Kernel_ > * > const &, unsigned, unsigned,
+					vector< vector< Canonical_loop< Kernel_ > * > > & ) >(
+					&Complex< Kernel_ >::compute_canonical_loops_for ),
+					this, boost::cref( sample ), i, number_of_threads,
+					boost::ref( canonical_loops ) ) );
+			}
+			threads.join_all();
+
 			if ( m_verbose )
-				++( *m_p_progress );
+				( *m_p_progress ) += sample_size;
 		}
+
+		m_canonical_loops.reserve( sample_size * basis_rank() );
+		for ( unsigned i( 0 ); i != sample_size; ++i )
+		{
+			m_canonical_loops.insert( m_canonical_loops.end(),
+				canonical_loops.at( i ).begin(), canonical_loops.at( i ).end() );
+		}
+
 		if ( m_verbose )
 		{
 			cout << m_canonical_loops.size() << " canonical loops computed in "
@@ -1652,96 +2094,48 @@ namespace trackLoop
 			m_timer.restart();
 		}
 
-		sort( m_canonical_loops.begin(), m_canonical_loops.end(),
+		// equally long loops keep the order of their sources, so that the
+		// choice among them does not depend on the longer loops, which the
+		// bounded search leaves out
+		stable_sort( m_canonical_loops.begin(), m_canonical_loops.end(),
 			pointee_norm_is_less );
 
-		typedef Vector_d< Homogeneous_d< int > > Vector_d;
-		vector< Vector_d > basis;
-		basis.reserve( basis_rank() );
+		Z2_basis basis( basis_rank() );
+
+		Shortest_path_tree< Kernel_ > tree;
+		tree.resize( number_of_vertices(), number_of_edges() );
 
 		unsigned i( 0 );
-		
+
 		for ( ; i != m_canonical_loops.size(); ++i )
 		{
 			Canonical_loop< Kernel_ > &canonical( *m_canonical_loops.at( i ) );
 
 			// Test if independent; if no, proceed
-
-			dynamic_bitset<> &bits( canonical.bits() );
-
-			// static 
-			vector< int > coeffs( basis_rank() );
-			for ( unsigned j( 0 ); j != basis_rank(); ++j )
-				coeffs.at( j ) = ( bits.test( j ) ? 1 : 0 );
-			
-			Vector_d current( basis_rank(), coeffs.begin(), coeffs.end() );
-			basis.push_back( current );
-
-			if ( !linearly_independent( basis.begin(), basis.end() ) )
+			if ( !basis.insert( canonical.bits() ) )
 			{
-				basis.pop_back();
-
 				if ( m_verbose )
 					++( *m_p_progress );
 
 				continue;
 			}
 
-			Basis_loop< Kernel_ > *p_basis_loop( new Basis_loop< Kernel_ > );
-
 			Vertex< Kernel_ > &vertex( canonical.vertex() );
 			Edge< Kernel_ > &edge( canonical.edge() );
 
-			compute_shortest_path_tree_for( vertex );
+			compute_shortest_path_tree_for( vertex, tree );
 
 			// Compute actual canonical loop in the initial complex
+			vector< Edge< Kernel_ > * > chain;
+			append_path_to_root( edge.a(), tree, chain );
+			append_path_to_root( edge.b(), tree, chain );
+			chain.push_back( &edge );
 
-			Vertex< Kernel_ > *p_a( &edge.a() );
-			while ( p_a->has_parent() )
-			{
-				p_a->edge_to_parent().toggle_flag(
-					Edge< Kernel_ >::IS_IN_LOOP );
-				p_a = &p_a->parent();
-			}
-
-			Vertex< Kernel_ > *p_b( &edge.b() );
-			while ( p_b->has_parent() )
-			{
-				p_b->edge_to_parent().toggle_flag(
-					Edge< Kernel_ >::IS_IN_LOOP );
-				p_b = &p_b->parent();
-			}
-
-			p_a = &edge.a();
-			while ( p_a->has_parent() )
-			{
-				Edge< Kernel_ > &edge_to_parent( p_a->edge_to_parent() );
-				if ( edge_to_parent.has_flag( Edge< Kernel_ >::IS_IN_LOOP ) )
-				{
-					edge_to_parent.clear_flag( Edge< Kernel_ >::IS_IN_LOOP );
-					p_basis_loop->push_back( &edge_to_parent );
-				}
-				p_a = &p_a->parent();
-			}
-
-			p_b = &edge.b();
-			while ( p_b->has_parent() )
-			{
-				Edge< Kernel_ > &edge_to_parent( p_b->edge_to_parent() );
-				if ( edge_to_parent.has_flag( Edge< Kernel_ >::IS_IN_LOOP ) )
-				{
-					edge_to_parent.clear_flag( Edge< Kernel_ >::IS_IN_LOOP );
-					p_basis_loop->push_back( &edge_to_parent );
-				}
-				p_b = &p_b->parent();
-			}
-
-			p_basis_loop->push_back( &edge );
-			m_basis_loops.at( basis.size() - 1 ) = p_basis_loop;
+			m_basis_loops.at( basis.rank() - 1 ) = create_loop( chain );
 
-			clear_shortest_path_tree();
+			tree.clear();
 
-			if ( basis.size() == basis_rank() )
+			if ( basis.rank() == basis_rank() )
 				break;
 
 			if ( m_verbose )
@@ -1761,235 +2155,452 @@ namespace trackLoop
 	}
 
 	template< typename Kernel_ >
-	inline bool
-	pointee_canonical_loop_length_is_less( Edge< Kernel_ > *p_a_,
-		Edge< Kernel_ > *p_b_ )
+	inline Edge< Kernel_ > *
+	Complex< Kernel_ >::find_edge( Vertex< Kernel_ > &a_, Vertex< Kernel_ > &b_ )
 	{
-		return p_a_->canonical_loop_length() < p_b_->canonical_loop_length();
+		VV ab_key( std::min( &a_, &b_ ), std::max( &a_, &b_ ) );
+
+		typename VV2E::iterator it( m_vv2e.find( ab_key ) );
+		return it == m_vv2e.end() ? 0 : it->second;
 	}
 
 	template< typename Kernel_ >
-	inline void
-	Complex< Kernel_ >::compute_canonical_loops_for(
-		Vertex< Kernel_ > &vertex_ )
+	inline boost::dynamic_bitset<>
+	Complex< Kernel_ >::homology_class(
+		std::vector< Edge< Kernel_ > * > const &edges_ ) const
+	{
+		boost::dynamic_bitset<> bits( basis_rank() );
+
+		for ( unsigned i( 0 ); i != edges_.size(); ++i )
+		{
+			std::vector< Edge< Kernel_ > * > const &image( edges_.at( i )->image() );
+			for ( unsigned j( 0 ); j != image.size(); ++j )
+				bits.flip( e2b( image.at( j )->index() ) );
+		}
+
+		return bits;
+	}
+
+	template< typename Kernel_ >
+	inline Basis_loop< Kernel_ > *
+	Complex< Kernel_ >::shortest_nontrivial_loop_through( Edge< Kernel_ > &edge_,
+		Headers::Z2_basis &alive_classes_ )
 	{
 		using namespace std;
-		using namespace CGAL;
 		using namespace boost;
-		compute_shortest_path_tree_for( vertex_ );
-		compute_canonical_loop_lengths();
-		
-		sort( m_edges.begin(), m_edges.end(),
-			pointee_canonical_loop_length_is_less< Kernel_ > );
-		typedef Vector_d< Homogeneous_d< int > > Vector_d;
-		vector< Vector_d > basis;
-		basis.reserve( basis_rank() );
-		// static dynamic_bitset<> bits;
-		for ( unsigned i( m_tree_size ); i != number_of_edges(); ++i )
-		{
-			Edge< Kernel_ > &edge( edge_at( i ) );
-			if ( edge.canonical_loop_length() == INFINITY )
-				continue;
 
-			// Represents the canonical loop in the contracted complex
-			dynamic_bitset<> bits( basis_rank() );
+		if ( basis_rank() == 0 )
+			return 0;
 
-			// cout<<edge.a().index()<<" basis_rank: "<<basis_rank()<<" bits: "<<bits<<"\n";	
-			bits.reset();
+		Vertex< Kernel_ > &a( edge_.a() );
+		Vertex< Kernel_ > &b( edge_.b() );
 
-			bits ^= edge.a().contracted_path_to_root();
+		dynamic_bitset<> edge_bits( homology_class(
+			vector< Edge< Kernel_ > * >( 1, &edge_ ) ) );
 
-			bits ^= edge.b().contracted_path_to_root();
-			
-			vector< Edge< Kernel_ > * > &image( edge.image() );
-			for ( unsigned i( 0 ); i != image.size(); ++i )
-				bits.flip( e2b( image.at( i )->index() ) );
+		Shortest_path_tree< Kernel_ > &a_tree( m_a_tree );
+		a_tree.resize( number_of_vertices(), number_of_edges() );
 
-			if ( bits.none() )
-				continue;
+		// The shortest loop through the edge closes it with the shortest
+		// path between its endpoints, so the tree only has to grow until
+		// the other endpoint is reached
+		compute_shortest_path_tree_for( a, a_tree, &edge_, &b );
 
-			// Test if independent; if no, proceed
+		// no loop passes through a bridge
+		if ( !a_tree.is_in_tree( b ) )
+			return 0;
 
-			vector< int > coeffs( basis_rank() );
-			for ( unsigned i( 0 ); i != basis_rank(); ++i )
-				coeffs.at( i ) = ( bits.test( i ) ? 1 : 0 );
+		dynamic_bitset<> bits( edge_bits );
+		add_contracted_path( b, a, a_tree, bits );
+		if ( bits.any() && alive_classes_.is_independent( bits ) )
+		{
+			vector< Edge< Kernel_ > * > chain( 1, &edge_ );
+			append_path_to_root( b, a_tree, chain );
 
-			Vector_d current( basis_rank(), coeffs.begin(), coeffs.end() );
-			basis.push_back( current );
+			return create_loop( chain );
+		}
 
-			if ( !linearly_independent( basis.begin(), basis.end() ) )
+		// Otherwise, the loop has to leave the shortest path; candidates
+		// are formed by the edge, some other edge xy and the tree paths
+		// connecting x to a and y to b. Neither path of a candidate is
+		// longer than the candidate, so trees of some radius give every
+		// candidate up to that length. The radius starts at twice the
+		// shortest path and doubles until a candidate within it is
+		// independent or the trees span the component
+		Shortest_path_tree< Kernel_ > &b_tree( m_b_tree );
+		b_tree.resize( number_of_vertices(), number_of_edges() );
+
+		// ( length, 2 * index of xy + 1 if x is xy.b() )
+		typedef pair< double, unsigned > Candidate;
+		vector< Candidate > candidates;
+
+		double tested( -INFINITY );
+		double radius( 2 * a_tree.distance_to_root( b ) );
+		for ( ;; )
+		{
+			a_tree.clear();
+			b_tree.clear();
+			bool is_complete( compute_shortest_path_tree_for(
+				a, a_tree, &edge_, 0, radius ) );
+			is_complete = compute_shortest_path_tree_for(
+				b, b_tree, &edge_, 0, radius ) && is_complete;
+
+			// Candidates up to the previous radius were all found dependent;
+			// x is among the vertices touched by the search from a
+			candidates.clear();
+			vector< unsigned > const &touched( a_tree.touched_vertices() );
+			for ( unsigned i( 0 ); i != touched.size(); ++i )
 			{
-				basis.pop_back();
-				continue;
+				Vertex< Kernel_ > &x( vertex_at( touched[ i ] ) );
+				if ( !a_tree.is_in_tree( x ) )
+					continue;
+
+				for ( unsigned j( 0 ); j != x.coboundary().size(); ++j )
+				{
+					Edge< Kernel_ > &xy( *x.coboundary().at( j ) );
+					if ( &xy == &edge_ )
+						continue;
+
+					bool is_reversed( &xy.b() == &x );
+					Vertex< Kernel_ > &y( is_reversed ? xy.a() : xy.b() );
+					if ( !b_tree.is_in_tree( y ) )
+						continue;
+
+					double length( a_tree.distance_to_root( x ) + xy.length()
+						+ b_tree.distance_to_root( y ) );
+					if ( length > tested && ( is_complete || length <= radius ) )
+						candidates.push_back( Candidate( length,
+							2 * xy.index() + ( is_reversed ? 1 : 0 ) ) );
+				}
 			}
 
-			// New independent canonical loop found
-			m_canonical_loops.push_back( new Canonical_loop< Kernel_ >(
-				vertex_, edge, bits ) );
+			sort( candidates.begin(), candidates.end() );
 
-			if ( basis.size() == basis_rank() )
-				break;
+			for ( unsigned i( 0 ); i != candidates.size(); ++i )
+			{
+				Edge< Kernel_ > &xy( edge_at( candidates.at( i ).second / 2 ) );
+				bool is_reversed( candidates.at( i ).second % 2 == 1 );
 
+				Vertex< Kernel_ > &x( is_reversed ? xy.b() : xy.a() );
+				Vertex< Kernel_ > &y( is_reversed ? xy.a() : xy.b() );
+
+				dynamic_bitset<> bits( edge_bits
+					^ homology_class( vector< Edge< Kernel_ > * >( 1, &xy ) ) );
+				add_contracted_path( x, a, a_tree, bits );
+				add_contracted_path( y, b, b_tree, bits );
+
+				if ( bits.none() || !alive_classes_.is_independent( bits ) )
+					continue;
+
+				vector< Edge< Kernel_ > * > chain( 1, &edge_ );
+				append_path_to_root( x, a_tree, chain );
+				chain.push_back( &xy );
+				append_path_to_root( y, b_tree, chain );
+
+				return create_loop( chain );
+			}
+
+			if ( is_complete )
+				return 0;
+
+			tested = radius;
+			radius = ( radius > 0 ? 2 * radius : INFINITY );
 		}
+	}
 
-		clear_shortest_path_tree();
+	template< typename Kernel_ >
+	inline void
+	Complex< Kernel_ >::append_path_to_root( Vertex< Kernel_ > &vertex_,
+		Shortest_path_tree< Kernel_ > const &tree_,
+		std::vector< Edge< Kernel_ > * > &chain_ ) const
+	{
+		Vertex< Kernel_ > *p_vertex( &vertex_ );
+		while ( tree_.has_parent( *p_vertex ) )
+		{
+			chain_.push_back( &tree_.edge_to_parent( *p_vertex ) );
+			p_vertex = &tree_.parent( *p_vertex );
+		}
 	}
 
-	template< typename Vertex_ >
-	struct Pointee_distance_to_root_is_less
+	template< typename Kernel_ >
+	inline void
+	Complex< Kernel_ >::add_contracted_path( Vertex< Kernel_ > const &a_,
+		Vertex< Kernel_ > const &b_, Shortest_path_tree< Kernel_ > const &tree_,
+		boost::dynamic_bitset<> &bits_ ) const
 	{
-		bool operator()( Vertex_ const *p_a_, Vertex_ const *p_b_ ) const
+		Vertex< Kernel_ > const *p_a( tree_.image_ancestor( a_ ) );
+		Vertex< Kernel_ > const *p_b( tree_.image_ancestor( b_ ) );
+
+		// the deeper one moves up until both meet; 0 stands for the root
+		while ( p_a != p_b )
 		{
-			return p_a_->distance_to_root() < p_b_->distance_to_root();
+			if ( p_a == 0 || ( p_b != 0 &&
+				tree_.image_depth( *p_a ) < tree_.image_depth( *p_b ) ) )
+				std::swap( p_a, p_b );
+
+			std::vector< Edge< Kernel_ > * > const &image(
+				tree_.edge_to_parent( *p_a ).image() );
+			for ( unsigned i( 0 ); i != image.size(); ++i )
+				bits_.flip( e2b( image[ i ]->index() ) );
+
+			p_a = tree_.image_ancestor( tree_.parent( *p_a ) );
 		}
-	};
-	
-	template< typename Vertex_ >
-	struct Property_map	
-		: public boost::put_get_helper< size_t, Property_map< Vertex_ > >
+	}
+
+	template< typename Kernel_ >
+	inline Basis_loop< Kernel_ > *
+	Complex< Kernel_ >::create_loop(
+		std::vector< Edge< Kernel_ > * > const &chain_ )
 	{
-		typedef Vertex_ *key_type;
-		typedef size_t value_type;
-		typedef size_t reference;
-		typedef boost::readable_property_map_tag category;
+		for ( unsigned i( 0 ); i != chain_.size(); ++i )
+			chain_.at( i )->toggle_flag( Edge< Kernel_ >::IS_IN_LOOP );
 
-		value_type operator[]( key_type key_ ) const
+		Basis_loop< Kernel_ > *p_loop( new Basis_loop< Kernel_ > );
+
+		for ( unsigned i( 0 ); i != chain_.size(); ++i )
 		{
-			return key_->index();
+			Edge< Kernel_ > &edge( *chain_.at( i ) );
+			if ( edge.has_flag( Edge< Kernel_ >::IS_IN_LOOP ) )
+			{
+				edge.clear_flag( Edge< Kernel_ >::IS_IN_LOOP );
+				p_loop->push_back( &edge );
+			}
 		}
-	};
+
+		return p_loop;
+	}
 
 	template< typename Kernel_ >
 	inline void
-	Complex< Kernel_ >::compute_shortest_path_tree_for(
-		Vertex< Kernel_ > &vertex_ )
+	Complex< Kernel_ >::compute_canonical_loops_for(
+		std::vector< Vertex< Kernel_ > * > const &sources_, unsigned first_,
+		unsigned stride_,
+		std::vector< std::vector< Canonical_loop< Kernel_ > * > > &canonical_loops_ )
+	{
+		Shortest_path_tree< Kernel_ > tree;
+		tree.resize( number_of_vertices(), number_of_edges() );
+
+		for ( unsigned i( first_ ); i < sources_.size(); i += stride_ )
+		{
+			compute_canonical_loops_for( *sources_.at( i ), tree,
+				canonical_loops_.at( i ) );
+
+			// the progress display is not shared between threads
+			if ( m_verbose && stride_ == 1 )
+				++( *m_p_progress );
+		}
+	}
+
+	template< typename Kernel_ >
+	inline void
+	Complex< Kernel_ >::compute_canonical_loops_for(
+		Vertex< Kernel_ > &vertex_, Shortest_path_tree< Kernel_ > &tree_,
+		std::vector< Canonical_loop< Kernel_ > * > &canonical_loops_ )
 	{
 		using namespace std;
 		using namespace boost;
+		using namespace Headers;
+
+		// A loop through edge ab is at least twice as long as the longer
+		// of the paths to a and b, so loops that can still enter the basis
+		// stay within half the bound; the slack covers rounding
+		double bound( INFINITY );
+		double radius( INFINITY );
+		{
+			boost::mutex::scoped_lock lock( m_loop_length_bound_mutex );
+			bound = m_loop_length_bound;
+			if ( bound != INFINITY )
+				radius = 0.5 * bound * ( 1 + 1e-9 );
+		}
+
+		compute_shortest_path_tree_for( vertex_, tree_, 0, 0, radius );
+		compute_canonical_loop_lengths( tree_ );
+
+		// Loops longer than the bound never enter the basis either
+		typedef pair< double, unsigned > Candidate;
+		vector< Candidate > &candidates( tree_.candidates() );
+		if ( bound != INFINITY )
+		{
+			unsigned kept( 0 );
+			for ( unsigned i( 0 ); i != candidates.size(); ++i )
+			{
+				if ( candidates[ i ].first <= bound )
+					candidates[ kept++ ] = candidates[ i ];
+			}
+			candidates.resize( kept );
+		}
 
-		m_tree_size = 0;
+		// The candidates are taken shortest first, ties broken by edge
+		// index, until the basis is full. That may happen after a few of
+		// them, so only a prefix of twice the rank is sorted up front, and
+		// the rest once the prefix is used up
+		unsigned sorted( std::min< unsigned >( candidates.size(), 2 * basis_rank() ) );
+		partial_sort( candidates.begin(), candidates.begin() + sorted,
+			candidates.end() );
+		Z2_basis basis( basis_rank() );
+		for ( unsigned i( 0 ); i != candidates.size(); ++i )
+		{
+			if ( i == sorted )
+			{
+				// the unsorted candidates are no shorter than the prefix
+				sort( candidates.begin() + sorted, candidates.end() );
+				sorted = candidates.size();
+			}
 
-		typedef vector< Vertex< Kernel_ > * > Container;
-		typedef Pointee_distance_to_root_is_less< Vertex< Kernel_ > > Less;
-		typedef Property_map< Vertex< Kernel_ > > Map;
+			Edge< Kernel_ > &edge( edge_at( candidates[ i ].second ) );
 
-		// we need a priority queue that allows changing the element value
-		typedef mutable_queue< Vertex< Kernel_ > *, Container,
-			Less, Map > Vertex_queue;
-		Vertex_queue vertex_queue( m_vertices.size(), Less(), Map() ) ;
+			// Represents the canonical loop in the contracted complex; the
+			// paths from the endpoints to the root cancel above their lowest
+			// common ancestor
+			dynamic_bitset<> bits( basis_rank() );
 
-		// Build the shortest path tree using Dijkstra algorithm
+			add_contracted_path( edge.a(), edge.b(), tree_, bits );
 
-		for ( unsigned i( 0 ); i != number_of_vertices(); ++i )
-			vertex_at( i ).set_distance_to_root( INFINITY );
+			vector< Edge< Kernel_ > * > &image( edge.image() );
+			for ( unsigned i( 0 ); i != image.size(); ++i )
+				bits.flip( e2b( image.at( i )->index() ) );
+
+			if ( bits.none() )
+				continue;
+
+			// Test if independent; if no, proceed
+			if ( !basis.insert( bits ) )
+				continue;
+
+			// New independent canonical loop found
+			canonical_loops_.push_back( new Canonical_loop< Kernel_ >(
+				vertex_, edge, bits, tree_.canonical_loop_length( edge ) ) );
+
+			if ( basis.rank() == basis_rank() )
+			{
+				// the loops of this source form a basis
+				boost::mutex::scoped_lock lock( m_loop_length_bound_mutex );
+				m_loop_length_bound = std::min( m_loop_length_bound,
+					tree_.canonical_loop_length( edge ) );
+				break;
+			}
+
+		}
+
+		tree_.clear();
+	}
+
+	template< typename Kernel_ >
+	inline bool
+	Complex< Kernel_ >::compute_shortest_path_tree_for(
+		Vertex< Kernel_ > &vertex_, Shortest_path_tree< Kernel_ > &tree_,
+		Edge< Kernel_ > const *p_excluded_edge_,
+		Vertex< Kernel_ > const *p_target_, double radius_ )
+	{
+		using namespace std;
+		using namespace boost;
+
+		// the queue is keyed by the distances to the root; only reached
+		// vertices enter it, so it runs dry at the end of the component
+		Headers::Dary_heap &vertex_queue( tree_.queue() );
 
-		vertex_.set_distance_to_root( 0 );
+		// Build the shortest path tree using Dijkstra algorithm
 
-		vertex_queue.push( &vertex_ );
-		vertex_.set_flag( Vertex< Kernel_ >::IS_IN_QUEUE );
+		tree_.set_distance_to_root( vertex_, 0 );
+
+		vertex_queue.push( vertex_.index(), 0 );
+		tree_.set_in_queue( vertex_, true );
 
 		while ( !vertex_queue.empty() )
 		{
-			Vertex< Kernel_ > &current( *vertex_queue.top() );
+			Vertex< Kernel_ > &current( *m_vertices[ vertex_queue.top() ] );
 
-			// INFTY means current belongs to another component
-			if ( current.distance_to_root() == INFINITY )
-				break;
+			if ( vertex_queue.top_key() > radius_ )
+				return false;
 
 			vertex_queue.pop();
-			current.clear_flag( Vertex< Kernel_ >::IS_IN_QUEUE );
-			current.set_flag( Vertex< Kernel_ >::IS_IN_TREE );
+			tree_.set_in_queue( current, false );
+			tree_.set_in_tree( current );
 
-			if ( current.has_parent() )
+			if ( tree_.has_parent( current ) )
 			{
-				current.contracted_path_to_root() =
-					current.parent().contracted_path_to_root();
-
-				Edge< Kernel_ > &edge_to_parent( current.edge_to_parent() );
-				edge_to_parent.set_flag( Edge< Kernel_ >::IS_IN_TREE );
-				++m_tree_size;
-
-				for ( unsigned i( 0 ); i != edge_to_parent.image().size(); ++i )
-				{					
-					Edge< Kernel_ > &image( *edge_to_parent.image().at( i ) );
-					unsigned index( e2b( image.index() ) );
-					assert( index != -1 );
-					current.contracted_path_to_root().flip( index );
-				}
+				Vertex< Kernel_ > &parent( tree_.parent( current ) );
+				Edge< Kernel_ > &edge_to_parent( tree_.edge_to_parent( current ) );
+				tree_.set_in_tree( edge_to_parent );
+
+				if ( edge_to_parent.image().empty() )
+					tree_.set_image_ancestor( current,
+						tree_.image_ancestor( parent ), tree_.image_depth( parent ) );
+				else
+					tree_.set_image_ancestor( current, &current,
+						tree_.image_depth( parent ) + 1 );
 			}
 
+			if ( &current == p_target_ )
+				return false;
+
 			for ( unsigned i( 0 ); i != current.coboundary().size(); ++i )
 			{
 				Edge< Kernel_ > &edge( *current.coboundary().at( i ) );
+				if ( &edge == p_excluded_edge_ )
+					continue;
+
 				Vertex< Kernel_ > &neighbor( &edge.a() == &current ?
 					edge.b() : edge.a() );
 
-				if ( neighbor.has_flag( Vertex< Kernel_ >::IS_IN_TREE ) )
+				if ( tree_.is_in_tree( neighbor ) )
 					continue;
 
-				double distance_to_root( current.distance_to_root()
+				double distance_to_root( tree_.distance_to_root( current )
 					+ edge.length() );
-				if ( distance_to_root < neighbor.distance_to_root() )
+				if ( distance_to_root < tree_.distance_to_root( neighbor ) )
 				{
-					neighbor.set_distance_to_root( distance_to_root );
-					neighbor.set_edge_to_parent( edge );
-				}
+					tree_.set_distance_to_root( neighbor, distance_to_root );
+					tree_.set_edge_to_parent( neighbor, edge );
 
-				if ( neighbor.has_flag( Vertex< Kernel_ >::IS_IN_QUEUE ) )
-					vertex_queue.update( &neighbor );
-				else
-				{
-					neighbor.set_flag( Vertex< Kernel_ >::IS_IN_QUEUE );
-					vertex_queue.push( &neighbor );
+					if ( tree_.is_in_queue( neighbor ) )
+						vertex_queue.decrease( neighbor.index(), distance_to_root );
+					else
+					{
+						tree_.set_in_queue( neighbor, true );
+						vertex_queue.push( neighbor.index(), distance_to_root );
+					}
 				}
 			}
 		}
-	}
-
-	template< typename Kernel_ >
-	inline void
-	Complex< Kernel_ >::clear_shortest_path_tree()
-	{
-		for ( unsigned i( 0 ); i != number_of_vertices(); ++i )
-		{
-			Vertex< Kernel_ > &vertex( vertex_at( i ) );
-
-			vertex.clear_flag( Vertex< Kernel_ >::IS_IN_TREE );
-			vertex.clear_edge_to_parent();
-
-			vertex.contracted_path_to_root().reset();
-		}
 
-		for ( unsigned i( 0 ); i != number_of_edges(); ++i )
-		{
-			Edge< Kernel_ > &edge( edge_at( i ) );
-			edge.clear_flag( Edge< Kernel_ >::IS_IN_TREE );
-			edge.set_canonical_loop_length( INFINITY );
-		}
+		return true;
 	}
 
 	template< typename Kernel_ >
 	inline void
-	Complex< Kernel_ >::compute_canonical_loop_lengths()
-	{
-		for ( unsigned i( 0 ); i != number_of_edges(); ++i )
+	Complex< Kernel_ >::compute_canonical_loop_lengths(
+		Shortest_path_tree< Kernel_ > &tree_ )
+	{
+		// Only the edges at the vertices of the tree are scored; edges with
+		// an endpoint out of the tree, which is in another component or
+		// beyond the radius of the search, keep the infinite length. Each
+		// scored edge off the tree becomes a candidate once, from its a()
+		std::vector< std::pair< double, unsigned > > &candidates(
+			tree_.candidates() );
+		candidates.clear();
+
+		// the vertices of the tree were all touched by the search
+		std::vector< unsigned > const &touched( tree_.touched_vertices() );
+		for ( unsigned i( 0 ); i != touched.size(); ++i )
 		{
-			Edge< Kernel_ > &edge( edge_at( i ) );
+			Vertex< Kernel_ > &vertex( *m_vertices[ touched[ i ] ] );
+			if ( !tree_.is_in_tree( vertex ) )
+				continue;
 
-			if ( edge.has_flag( Edge< Kernel_ >::IS_IN_TREE ) )
-				edge.set_canonical_loop_length( 0 );
-			else
+			for ( unsigned j( 0 ); j != vertex.coboundary().size(); ++j )
 			{
-				Vertex< Kernel_ > &a( edge.a() ), &b( edge.b() );
+				Edge< Kernel_ > &edge( *vertex.coboundary().at( j ) );
 
-				if ( a.distance_to_root() == INFINITY )
-					edge.set_canonical_loop_length( INFINITY );
-				else if ( b.distance_to_root() == INFINITY )
-					edge.set_canonical_loop_length( INFINITY );
-				else
+				if ( tree_.is_in_tree( edge ) )
+					tree_.set_canonical_loop_length( edge, 0 );
+				else if ( &edge.a() == &vertex && tree_.is_in_tree( edge.b() ) )
 				{
-					edge.set_canonical_loop_length( edge.length() +
-						a.distance_to_root() + b.distance_to_root() );
+					tree_.set_canonical_loop_length( edge, edge.length() +
+						tree_.distance_to_root( edge.a() ) +
+						tree_.distance_to_root( edge.b() ) );
+					candidates.push_back( std::make_pair(
+						tree_.canonical_loop_length( edge ), edge.index() ) );
 				}
 			}
 		}
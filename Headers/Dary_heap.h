@@ -0,0 +1,234 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// THIS SOFTWARE IS PROVIDED "AS-IS". THERE IS NO WARRANTY OF ANY KIND.
+// NEITHER THE AUTHORS NOR THE OHIO STATE UNIVERSITY WILL BE LIABLE
+// FOR ANY DAMAGES OF ANY KIND, EVEN IF ADVISED OF SUCH POSSIBILITY.
+//
+// Copyright (c) 2010 Jyamiti Research Group.
+// CS&E Department of the Ohio State University, Columbus, OH.
+// All rights reserved.
+//
+// Author: Sayan Mandal
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef HEADERS_DARY_HEAP_H
+#define HEADERS_DARY_HEAP_H
+
+#include <vector>
+#include <algorithm>
+#include <cassert>
+
+namespace Headers
+{
+	///////////////////////////////////////////////////////////////////////////
+	//
+	// Min-heap of the items 0, ..., n - 1 keyed by doubles, with decrease
+	// key; the Dijkstra queue of the shortest path searches. Every node has
+	// four children and the keys are stored next to the items, so a sift
+	// step compares entries of one contiguous array. Equal keys are ordered
+	// by item.
+	//
+	///////////////////////////////////////////////////////////////////////////
+
+	class Dary_heap
+	{
+
+	public:
+
+		Dary_heap( unsigned number_of_items_ = 0 );
+
+		// Empties the heap and allows the items 0, ..., number_of_items_ - 1;
+		// costs the size of the heap and the number of items added
+		void resize( unsigned number_of_items_ );
+
+		bool empty() const;
+		unsigned size() const;
+		bool contains( unsigned item_ ) const;
+
+		// Item with the smallest key and its key
+		unsigned top() const;
+		double top_key() const;
+
+		void push( unsigned item_, double key_ );
+		// The key of the item must not grow
+		void decrease( unsigned item_, double key_ );
+		void pop();
+
+		// Removes the remaining items; costs the size of the heap
+		void clear();
+
+	private:
+
+		struct Entry
+		{
+			double key;
+			unsigned item;
+		};
+
+		enum
+		{
+			ARITY = 4,
+			NOT_IN_HEAP = ~0u
+		};
+
+		static bool is_less( Entry const &a_, Entry const &b_ );
+
+		void sift_up( unsigned position_, Entry entry_ );
+		void sift_down( unsigned position_, Entry entry_ );
+
+	private:
+
+		std::vector< Entry > m_entries;
+
+		// Position of each item in m_entries, or NOT_IN_HEAP
+		std::vector< unsigned > m_positions;
+	};
+
+	inline
+	Dary_heap::Dary_heap( unsigned number_of_items_ )
+		: m_positions( number_of_items_, unsigned( NOT_IN_HEAP ) )
+	{
+	}
+
+	inline void
+	Dary_heap::resize( unsigned number_of_items_ )
+	{
+		clear();
+		m_positions.resize( number_of_items_, unsigned( NOT_IN_HEAP ) );
+	}
+
+	inline bool
+	Dary_heap::empty() const
+	{
+		return m_entries.empty();
+	}
+
+	inline unsigned
+	Dary_heap::size() const
+	{
+		return m_entries.size();
+	}
+
+	inline bool
+	Dary_heap::contains( unsigned item_ ) const
+	{
+		return m_positions[ item_ ] != NOT_IN_HEAP;
+	}
+
+	inline unsigned
+	Dary_heap::top() const
+	{
+		assert( !empty() );
+		return m_entries.front().item;
+	}
+
+	inline double
+	Dary_heap::top_key() const
+	{
+		assert( !empty() );
+		return m_entries.front().key;
+	}
+
+	inline void
+	Dary_heap::push( unsigned item_, double key_ )
+	{
+		assert( !contains( item_ ) );
+
+		Entry entry = { key_, item_ };
+		m_entries.push_back( entry );
+		sift_up( m_entries.size() - 1, entry );
+	}
+
+	inline void
+	Dary_heap::decrease( unsigned item_, double key_ )
+	{
+		assert( contains( item_ ) );
+		assert( !( m_entries[ m_positions[ item_ ] ].key < key_ ) );
+
+		Entry entry = { key_, item_ };
+		sift_up( m_positions[ item_ ], entry );
+	}
+
+	inline void
+	Dary_heap::pop()
+	{
+		assert( !empty() );
+
+		m_positions[ m_entries.front().item ] = NOT_IN_HEAP;
+
+		Entry last( m_entries.back() );
+		m_entries.pop_back();
+		if ( !m_entries.empty() )
+			sift_down( 0, last );
+	}
+
+	inline void
+	Dary_heap::clear()
+	{
+		for ( unsigned i( 0 ); i != m_entries.size(); ++i )
+			m_positions[ m_entries[ i ].item ] = NOT_IN_HEAP;
+		m_entries.clear();
+	}
+
+	inline bool
+	Dary_heap::is_less( Entry const &a_, Entry const &b_ )
+	{
+		if ( a_.key != b_.key )
+			return a_.key < b_.key;
+
+		return a_.item < b_.item;
+	}
+
+	inline void
+	Dary_heap::sift_up( unsigned position_, Entry entry_ )
+	{
+		// the entries on the way move down into the hole
+		while ( position_ > 0 )
+		{
+			unsigned parent( ( position_ - 1 ) / ARITY );
+			if ( !is_less( entry_, m_entries[ parent ] ) )
+				break;
+
+			m_entries[ position_ ] = m_entries[ parent ];
+			m_positions[ m_entries[ position_ ].item ] = position_;
+			position_ = parent;
+		}
+
+		m_entries[ position_ ] = entry_;
+		m_positions[ entry_.item ] = position_;
+	}
+
+	inline void
+	Dary_heap::sift_down( unsigned position_, Entry entry_ )
+	{
+		unsigned size( m_entries.size() );
+
+		for ( ; ; )
+		{
+			unsigned first_child( position_ * ARITY + 1 );
+			if ( first_child >= size )
+				break;
+
+			unsigned last_child( std::min< unsigned >( first_child + ARITY, size ) );
+			unsigned smallest( first_child );
+			for ( unsigned child( first_child + 1 ); child < last_child; ++child )
+			{
+				if ( is_less( m_entries[ child ], m_entries[ smallest ] ) )
+					smallest = child;
+			}
+
+			if ( !is_less( m_entries[ smallest ], entry_ ) )
+				break;
+
+			m_entries[ position_ ] = m_entries[ smallest ];
+			m_positions[ m_entries[ position_ ].item ] = position_;
+			position_ = smallest;
+		}
+
+		m_entries[ position_ ] = entry_;
+		m_positions[ entry_.item ] = position_;
+	}
+}
+
+#endif // HEADERS_DARY_HEAP_H
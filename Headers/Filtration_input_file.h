@@ -0,0 +1,506 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// THIS SOFTWARE IS PROVIDED "AS-IS". THERE IS NO WARRANTY OF ANY KIND.
+// NEITHER THE AUTHORS NOR THE OHIO STATE UNIVERSITY WILL BE LIABLE
+// FOR ANY DAMAGES OF ANY KIND, EVEN IF ADVISED OF SUCH POSSIBILITY.
+//
+// Copyright (c) 2010 Jyamiti Research Group.
+// CS&E Department of the Ohio State University, Columbus, OH.
+// All rights reserved.
+//
+// Author: Sayan Mandal
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef HEADERS_FILTRATION_INPUT_FILE_H
+#define HEADERS_FILTRATION_INPUT_FILE_H
+
+#include <File.h>
+#include <Noncopyable.h>
+#include <Exception.h>
+
+#include <cstddef>
+#include <cstring>
+#include <climits>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace Headers
+{
+	///////////////////////////////////////////////////////////////////////////
+	//
+	// One line of a filtration file: either "# k", which marks that the
+	// first k simplices have been inserted, or "i v0 v1 ...", which inserts
+	// the simplex spanned by the given vertices.
+	//
+	///////////////////////////////////////////////////////////////////////////
+
+	struct Filtration_record
+	{
+		enum Type
+		{
+			MARKER,
+			SIMPLEX
+		};
+
+		Type type;
+		int marker;
+		std::vector< int > vertices;
+	};
+
+	///////////////////////////////////////////////////////////////////////////
+	//
+	// Binary filtration format, all integers little-endian:
+	//
+	//   header   8 bytes "TLFILT\0" followed by the version byte
+	//            8 bytes flags; HAS_INDEX if the index is present
+	//            8 bytes offset of the end of the records
+	//   records  varint head; an odd head is a marker with k = head >> 1,
+	//            an even head is followed by head >> 1 varint vertices
+	//   index    optional, up to the end of the file; for each marker, in
+	//            order of k, the varint differences of k and of the offset
+	//            of its record from those of the previous marker
+	//
+	// Varints store 7 bits per byte, low bits first, with the high bit set
+	// on every byte but the last.
+	//
+	///////////////////////////////////////////////////////////////////////////
+
+	namespace Filtration_format
+	{
+		static char const MAGIC[ 8 ] = { 'T', 'L', 'F', 'I', 'L', 'T', '\0', 2 };
+		static std::size_t const HEADER_SIZE = 24;
+
+		enum Flags
+		{
+			HAS_INDEX = 1
+		};
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	//
+	// Reads a filtration file through a memory map, in either the text or
+	// the binary format; the latter is recognized by its header. Records are
+	// parsed in place, so lines may have any length, and the record passed
+	// to read() keeps its vertex buffer between calls. Comment lines
+	// ("c ...") and empty lines are skipped.
+	//
+	///////////////////////////////////////////////////////////////////////////
+
+	class Filtration_input_file
+		: public File, private Noncopyable
+	{
+
+	public:
+
+		Filtration_input_file( char const *path_cstring_ );
+		~Filtration_input_file();
+
+		bool is_binary() const;
+		bool has_index() const;
+
+		// Returns false at the end of the file
+		bool read( Filtration_record &record_ );
+
+		// Moves to the first marker "# k" with k at least the given one,
+		// so that read() returns it next; returns false, without moving,
+		// if the file has no index or no such marker
+		bool seek_marker( int k_ );
+
+	private:
+
+		bool read_text( Filtration_record &record_ );
+		bool read_binary( Filtration_record &record_ );
+
+		static bool is_blank( char c_ );
+
+		char const *skip_blanks( char const *p_ ) const;
+		char const *scan_integer( char const *p_, int &value_ );
+		char const *scan_varint( char const *p_, char const *p_end_,
+			unsigned long long &value_ );
+		char const *scan_varint( char const *p_, unsigned &value_ );
+
+		unsigned long long read_fixed( std::size_t offset_ ) const;
+		void read_index();
+
+		void error( char const *what_ );
+
+	private:
+
+		int m_descriptor;
+		std::size_t m_size;
+
+		char const *m_p_begin;
+		char const *m_p_end;
+		char const *m_p_current;
+
+		bool m_is_binary;
+		bool m_has_index;
+
+		// lines of a text file, records of a binary one
+		unsigned m_lines_read;
+
+		// ( k, offset of the record "# k" ), decoded by the first seek
+		std::vector< std::pair< unsigned long long, unsigned long long > > m_index;
+	};
+
+	inline
+	Filtration_input_file::Filtration_input_file( char const *path_cstring_ )
+		: File( path_cstring_ ), m_descriptor( open( path_cstring_, O_RDONLY ) ),
+		m_size( 0 ), m_p_begin( 0 ), m_p_end( 0 ), m_p_current( 0 ),
+		m_is_binary( false ), m_has_index( false ), m_lines_read( 0 )
+	{
+		if ( m_descriptor == -1 )
+		{
+			throw Exception( ( std::string( "Cannot open file " )
+				+ path_cstring_ ).c_str() );
+		}
+
+		struct stat status;
+		if ( fstat( m_descriptor, &status ) == -1 )
+		{
+			close( m_descriptor );
+			throw Exception( ( std::string( "Cannot stat file " )
+				+ path_cstring_ ).c_str() );
+		}
+
+		m_size = status.st_size;
+
+		// an empty file cannot be mapped, but has no records either
+		if ( m_size == 0 )
+			return;
+
+		void *p_map( mmap( 0, m_size, PROT_READ, MAP_PRIVATE, m_descriptor, 0 ) );
+		if ( p_map == MAP_FAILED )
+		{
+			close( m_descriptor );
+			throw Exception( ( std::string( "Cannot map file " )
+				+ path_cstring_ ).c_str() );
+		}
+
+		madvise( p_map, m_size, MADV_SEQUENTIAL );
+
+		m_p_begin = static_cast< char const * >( p_map );
+		m_p_end = m_p_begin + m_size;
+		m_p_current = m_p_begin;
+
+		using namespace Filtration_format;
+
+		// the last byte of the magic is the version
+		if ( m_size < sizeof( MAGIC )
+			|| memcmp( m_p_begin, MAGIC, sizeof( MAGIC ) - 1 ) != 0 )
+		{
+			return;
+		}
+
+		char const *what( 0 );
+		unsigned long long records_end( 0 );
+		if ( m_p_begin[ sizeof( MAGIC ) - 1 ] != MAGIC[ sizeof( MAGIC ) - 1 ] )
+			what = "Unsupported version of file ";
+		else if ( m_size < HEADER_SIZE )
+			what = "Corrupt header in file ";
+		else
+		{
+			unsigned long long flags( read_fixed( 8 ) );
+			records_end = read_fixed( 16 );
+
+			// without the index, the records run to the end of the file
+			m_has_index = ( flags & HAS_INDEX ) != 0;
+			if ( ( flags & ~static_cast< unsigned long long >( HAS_INDEX ) ) != 0
+				|| records_end < HEADER_SIZE || records_end > m_size
+				|| ( !m_has_index && records_end != m_size ) )
+			{
+				what = "Corrupt header in file ";
+			}
+		}
+
+		if ( what != 0 )
+		{
+			munmap( p_map, m_size );
+			close( m_descriptor );
+			throw Exception( ( std::string( what ) + path_cstring_ ).c_str() );
+		}
+
+		m_is_binary = true;
+		m_p_end = m_p_begin + records_end;
+		m_p_current = m_p_begin + HEADER_SIZE;
+	}
+
+	inline
+	Filtration_input_file::~Filtration_input_file()
+	{
+		if ( m_p_begin != 0 )
+			munmap( const_cast< char * >( m_p_begin ), m_size );
+
+		close( m_descriptor );
+	}
+
+	inline bool
+	Filtration_input_file::is_binary() const
+	{
+		return m_is_binary;
+	}
+
+	inline bool
+	Filtration_input_file::has_index() const
+	{
+		return m_has_index;
+	}
+
+	inline bool
+	Filtration_input_file::read( Filtration_record &record_ )
+	{
+		return m_is_binary ? read_binary( record_ ) : read_text( record_ );
+	}
+
+	inline bool
+	Filtration_input_file::seek_marker( int k_ )
+	{
+		if ( !m_has_index )
+			return false;
+
+		if ( m_index.empty() )
+			read_index();
+
+		std::vector< std::pair< unsigned long long, unsigned long long > >
+			::const_iterator it( std::lower_bound( m_index.begin(),
+			m_index.end(), std::make_pair( static_cast< unsigned long long >(
+			std::max( k_, 0 ) ), 0ULL ) ) );
+		if ( it == m_index.end() )
+			return false;
+
+		m_p_current = m_p_begin + it->second;
+		return true;
+	}
+
+	inline bool
+	Filtration_input_file::read_text( Filtration_record &record_ )
+	{
+		char const *p( m_p_current );
+
+		while ( p != m_p_end )
+		{
+			++m_lines_read;
+
+			p = skip_blanks( p );
+			if ( p == m_p_end )
+				break;
+
+			char type( *p );
+			if ( type == '\n' || type == 'c' )
+			{
+				while ( p != m_p_end && *p != '\n' )
+					++p;
+				if ( p != m_p_end )
+					++p;
+
+				continue;
+			}
+
+			p = skip_blanks( p + 1 );
+			record_.vertices.clear();
+
+			if ( type == '#' )
+			{
+				record_.type = Filtration_record::MARKER;
+				p = skip_blanks( scan_integer( p, record_.marker ) );
+			}
+			else if ( type == 'i' )
+			{
+				record_.type = Filtration_record::SIMPLEX;
+				while ( p != m_p_end && *p != '\n' )
+				{
+					int vertex;
+					p = skip_blanks( scan_integer( p, vertex ) );
+					record_.vertices.push_back( vertex );
+				}
+			}
+			else
+				error( "unknown record" );
+
+			if ( p != m_p_end )
+			{
+				if ( *p != '\n' )
+					error( "unexpected character" );
+				++p;
+			}
+
+			m_p_current = p;
+			return true;
+		}
+
+		m_p_current = p;
+		return false;
+	}
+
+	inline bool
+	Filtration_input_file::read_binary( Filtration_record &record_ )
+	{
+		char const *p( m_p_current );
+		if ( p == m_p_end )
+			return false;
+
+		++m_lines_read;
+
+		unsigned head;
+		p = scan_varint( p, head );
+
+		record_.vertices.clear();
+
+		if ( head & 1 )
+		{
+			record_.type = Filtration_record::MARKER;
+			record_.marker = head >> 1;
+		}
+		else
+		{
+			record_.type = Filtration_record::SIMPLEX;
+			for ( unsigned i( 0 ); i != head >> 1; ++i )
+			{
+				unsigned vertex;
+				p = scan_varint( p, vertex );
+				if ( vertex > 0x7fffffff )
+					error( "vertex out of range" );
+
+				record_.vertices.push_back( vertex );
+			}
+		}
+
+		m_p_current = p;
+		return true;
+	}
+
+	inline bool
+	Filtration_input_file::is_blank( char c_ )
+	{
+		return c_ == ' ' || c_ == '\t' || c_ == '\r';
+	}
+
+	inline char const *
+	Filtration_input_file::skip_blanks( char const *p_ ) const
+	{
+		while ( p_ != m_p_end && is_blank( *p_ ) )
+			++p_;
+
+		return p_;
+	}
+
+	inline char const *
+	Filtration_input_file::scan_integer( char const *p_, int &value_ )
+	{
+		if ( p_ == m_p_end || *p_ < '0' || *p_ > '9' )
+			error( "integer expected" );
+
+		int value( 0 );
+		for ( ; p_ != m_p_end && *p_ >= '0' && *p_ <= '9'; ++p_ )
+		{
+			int digit( *p_ - '0' );
+			if ( value > ( INT_MAX - digit ) / 10 )
+				error( "integer out of range" );
+
+			value = 10 * value + digit;
+		}
+
+		if ( p_ != m_p_end && *p_ != '\n' && !is_blank( *p_ ) )
+			error( "integer expected" );
+
+		value_ = value;
+		return p_;
+	}
+
+	inline char const *
+	Filtration_input_file::scan_varint( char const *p_, char const *p_end_,
+		unsigned long long &value_ )
+	{
+		unsigned long long value( 0 );
+		for ( unsigned shift( 0 ); ; shift += 7 )
+		{
+			if ( p_ == p_end_ )
+				error( "truncated record" );
+
+			unsigned char byte( *p_++ );
+			value |= static_cast< unsigned long long >( byte & 0x7f ) << shift;
+			if ( ( byte & 0x80 ) == 0 )
+				break;
+
+			if ( shift == 63 )
+				error( "varint too long" );
+		}
+
+		value_ = value;
+		return p_;
+	}
+
+	inline char const *
+	Filtration_input_file::scan_varint( char const *p_, unsigned &value_ )
+	{
+		unsigned long long value;
+		p_ = scan_varint( p_, m_p_end, value );
+
+		if ( value > 0xffffffffULL )
+			error( "varint out of range" );
+
+		value_ = static_cast< unsigned >( value );
+		return p_;
+	}
+
+	inline unsigned long long
+	Filtration_input_file::read_fixed( std::size_t offset_ ) const
+	{
+		unsigned long long value( 0 );
+		for ( unsigned i( 0 ); i != 8; ++i )
+		{
+			value |= static_cast< unsigned long long >(
+				static_cast< unsigned char >( m_p_begin[ offset_ + i ] ) ) << 8 * i;
+		}
+
+		return value;
+	}
+
+	inline void
+	Filtration_input_file::read_index()
+	{
+		char const *p( m_p_end );
+		char const *p_end( m_p_begin + m_size );
+
+		unsigned long long k( 0 );
+		unsigned long long offset( 0 );
+		while ( p != p_end )
+		{
+			unsigned long long delta;
+			p = scan_varint( p, p_end, delta );
+			k += delta;
+			p = scan_varint( p, p_end, delta );
+			offset += delta;
+
+			// every offset is that of a record
+			if ( offset < Filtration_format::HEADER_SIZE
+				|| offset >= static_cast< unsigned long long >( m_p_end - m_p_begin ) )
+			{
+				error( "index out of range" );
+			}
+
+			m_index.push_back( std::make_pair( k, offset ) );
+		}
+	}
+
+	inline void
+	Filtration_input_file::error( char const *what_ )
+	{
+		std::ostringstream message;
+		message << path().string() << ": " << what_
+			<< ( m_is_binary ? " at record " : " at line " ) << m_lines_read;
+
+		throw Exception( message.str().c_str() );
+	}
+}
+
+#endif // HEADERS_FILTRATION_INPUT_FILE_H
@@ -0,0 +1,198 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// THIS SOFTWARE IS PROVIDED "AS-IS". THERE IS NO WARRANTY OF ANY KIND.
+// NEITHER THE AUTHORS NOR THE OHIO STATE UNIVERSITY WILL BE LIABLE
+// FOR ANY DAMAGES OF ANY KIND, EVEN IF ADVISED OF SUCH POSSIBILITY.
+//
+// Copyright (c) 2010 Jyamiti Research Group.
+// CS&E Department of the Ohio State University, Columbus, OH.
+// All rights reserved.
+//
+// Author: Sayan Mandal
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef HEADERS_FILTRATION_OUTPUT_FILE_H
+#define HEADERS_FILTRATION_OUTPUT_FILE_H
+
+#include <Filtration_input_file.h>
+#include <File.h>
+#include <Noncopyable.h>
+#include <Exception.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace Headers
+{
+	///////////////////////////////////////////////////////////////////////////
+	//
+	// Writes a filtration in the binary format described in
+	// Filtration_input_file.h. The marker index, if asked for, is kept in
+	// memory and appended by close(), which also fills in the end of the
+	// records in the header.
+	//
+	///////////////////////////////////////////////////////////////////////////
+
+	class Filtration_output_file
+		: public File, private Noncopyable
+	{
+
+	public:
+
+		Filtration_output_file( char const *path_cstring_,
+			bool is_indexed_ = false );
+		~Filtration_output_file();
+
+		void write( Filtration_record const &record_ );
+		void close();
+
+	private:
+
+		void write_varint( unsigned long long value_ );
+		void write_fixed( unsigned long long value_ );
+
+		void error( char const *what_ );
+
+	private:
+
+		FILE *m_p_file;
+		unsigned long long m_offset;
+
+		bool m_is_indexed;
+
+		// ( k, offset of the record "# k" )
+		std::vector< std::pair< unsigned long long, unsigned long long > > m_index;
+	};
+
+	inline
+	Filtration_output_file::Filtration_output_file( char const *path_cstring_,
+		bool is_indexed_ )
+		: File( path_cstring_ ), m_p_file( fopen( path_cstring_, "wb" ) ),
+		m_offset( 0 ), m_is_indexed( is_indexed_ )
+	{
+		if ( m_p_file == 0 )
+		{
+			throw Exception( ( std::string( "Cannot open file " )
+				+ path_cstring_ ).c_str() );
+		}
+
+		using namespace Filtration_format;
+
+		fwrite( MAGIC, 1, sizeof( MAGIC ), m_p_file );
+		m_offset += sizeof( MAGIC );
+
+		write_fixed( m_is_indexed ? HAS_INDEX : 0 );
+
+		// the end of the records is not known until close()
+		write_fixed( 0 );
+	}
+
+	inline
+	Filtration_output_file::~Filtration_output_file()
+	{
+		if ( m_p_file != 0 )
+			fclose( m_p_file );
+	}
+
+	inline void
+	Filtration_output_file::write( Filtration_record const &record_ )
+	{
+		if ( record_.type == Filtration_record::MARKER )
+		{
+			if ( record_.marker < 0 )
+				error( "negative marker" );
+
+			if ( m_is_indexed )
+			{
+				// the index is searched by k
+				if ( !m_index.empty() && m_index.back().first
+					> static_cast< unsigned long long >( record_.marker ) )
+				{
+					error( "markers out of order" );
+				}
+
+				m_index.push_back( std::make_pair(
+					static_cast< unsigned long long >( record_.marker ), m_offset ) );
+			}
+			write_varint( 2ULL * record_.marker + 1 );
+
+			return;
+		}
+
+		write_varint( 2ULL * record_.vertices.size() );
+		for ( unsigned i( 0 ); i != record_.vertices.size(); ++i )
+		{
+			if ( record_.vertices.at( i ) < 0 )
+				error( "negative vertex" );
+
+			write_varint( record_.vertices.at( i ) );
+		}
+	}
+
+	inline void
+	Filtration_output_file::close()
+	{
+		unsigned long long records_end( m_offset );
+
+		unsigned long long previous_k( 0 );
+		unsigned long long previous_offset( 0 );
+		for ( unsigned i( 0 ); i != m_index.size(); ++i )
+		{
+			write_varint( m_index.at( i ).first - previous_k );
+			write_varint( m_index.at( i ).second - previous_offset );
+
+			previous_k = m_index.at( i ).first;
+			previous_offset = m_index.at( i ).second;
+		}
+
+		if ( fseek( m_p_file, sizeof( Filtration_format::MAGIC ) + 8,
+			SEEK_SET ) != 0 )
+		{
+			error( "cannot seek" );
+		}
+		write_fixed( records_end );
+
+		bool is_written( ferror( m_p_file ) == 0 );
+		is_written = fclose( m_p_file ) == 0 && is_written;
+		m_p_file = 0;
+
+		if ( !is_written )
+			error( "cannot write" );
+	}
+
+	inline void
+	Filtration_output_file::write_varint( unsigned long long value_ )
+	{
+		unsigned char bytes[ 10 ];
+		unsigned size( 0 );
+
+		for ( ; value_ >= 0x80; value_ >>= 7 )
+			bytes[ size++ ] = static_cast< unsigned char >( value_ | 0x80 );
+		bytes[ size++ ] = static_cast< unsigned char >( value_ );
+
+		fwrite( bytes, 1, size, m_p_file );
+		m_offset += size;
+	}
+
+	inline void
+	Filtration_output_file::write_fixed( unsigned long long value_ )
+	{
+		unsigned char bytes[ 8 ];
+		for ( unsigned i( 0 ); i != 8; ++i )
+			bytes[ i ] = static_cast< unsigned char >( value_ >> 8 * i );
+
+		fwrite( bytes, 1, 8, m_p_file );
+		m_offset += 8;
+	}
+
+	inline void
+	Filtration_output_file::error( char const *what_ )
+	{
+		throw Exception( ( path().string() + ": " + what_ ).c_str() );
+	}
+}
+
+#endif // HEADERS_FILTRATION_OUTPUT_FILE_H
@@ -45,7 +45,7 @@ char strLicense[] = "THIS SOFTWARE IS PROVIDED \"AS-IS\". THERE IS NO WARRANTY O
 
 
 
-bool ParseCommand(int argc, char** argv, std::string &input_pointcloud_file, std::string &filtration_file, double &sampling_coefficient){
+bool ParseCommand(int argc, char** argv, std::string &input_pointcloud_file, std::string &filtration_file, double &sampling_coefficient, unsigned &number_of_threads, bool &full_basis, std::string &binary_filtration_file, bool &index_markers){
 	try
 	{
 		/* Define the program options description
@@ -58,7 +58,11 @@ bool ParseCommand(int argc, char** argv, std::string &input_pointcloud_file, std
 			(",c", po::value<double>(&sampling_coefficient)->default_value(0.95), "Death point of barcode")
 			(",i", po::value<std::string>(&input_pointcloud_file)->default_value(""), "The file name for the initial point cloud")
 			//(",r", po::value<std::string>(&output_file)->default_value(""), "The file name containing killed output loop")
-			(",f", po::value<std::string>(&filtration_file)->default_value(""), "The file contains filtration after input");
+			(",f", po::value<std::string>(&filtration_file)->default_value(""), "The file contains filtration after input")
+			(",o", po::value<std::string>(&binary_filtration_file)->default_value(""), "Convert the filtration file to the binary format, write it to this file and exit")
+			(",x", po::bool_switch(&index_markers), "With -o, append an index of the marker offsets to the binary filtration")
+			(",t", po::value<unsigned>(&number_of_threads)->default_value(1), "Number of threads computing canonical loops")
+			(",b", po::bool_switch(&full_basis), "Search the whole shortest homology basis at born events instead of the loops through the new edge");
 			//(",s", po::value<std::string>(&output_persistence_file_name)->default_value("pers"), "The file name for the output 				persistence barcodes of input simplicial maps (default value: \"pers\")");
 		// Parser map
 		po::variables_map vm;
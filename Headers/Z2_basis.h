@@ -0,0 +1,233 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// THIS SOFTWARE IS PROVIDED "AS-IS". THERE IS NO WARRANTY OF ANY KIND.
+// NEITHER THE AUTHORS NOR THE OHIO STATE UNIVERSITY WILL BE LIABLE
+// FOR ANY DAMAGES OF ANY KIND, EVEN IF ADVISED OF SUCH POSSIBILITY.
+//
+// Copyright (c) 2010 Jyamiti Research Group.
+// CS&E Department of the Ohio State University, Columbus, OH.
+// All rights reserved.
+//
+// Author: Sayan Mandal
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef HEADERS_Z2_BASIS_H
+#define HEADERS_Z2_BASIS_H
+
+#include <vector>
+#include <cassert>
+
+#include <boost/dynamic_bitset.hpp>
+
+#if defined( __SSE2__ )
+#include <emmintrin.h>
+#endif
+
+#if defined( _MSC_VER )
+#include <intrin.h>
+#endif
+
+namespace Headers
+{
+	///////////////////////////////////////////////////////////////////////////
+	//
+	// Incremental echelon basis of vectors over Z2. Every stored row has a
+	// distinct pivot (its lowest set bit); a new vector is reduced against
+	// the rows in the order of its set bits, which costs at most rank row
+	// XORs of dimension / 64 words each.
+	//
+	///////////////////////////////////////////////////////////////////////////
+
+	class Z2_basis
+	{
+
+	public:
+
+		typedef boost::dynamic_bitset<>::block_type Block;
+
+	public:
+
+		Z2_basis( unsigned dimension_ );
+
+		unsigned dimension() const;
+		unsigned rank() const;
+
+		// Stores the vector and returns true if it is independent of the
+		// vectors inserted so far; otherwise, leaves the basis unchanged
+		bool insert( boost::dynamic_bitset<> const &bits_ );
+		bool is_independent( boost::dynamic_bitset<> const &bits_ );
+
+		void clear();
+
+	private:
+
+		// Reduces m_buffer against the stored rows; returns the pivot of
+		// what is left, or dimension() if the vector reduced to zero
+		unsigned reduce();
+
+		static void xor_blocks( Block *p_destination_, Block const *p_source_,
+			unsigned size_ );
+
+		// Index of the lowest set bit of a nonzero block
+		static unsigned lowest_set_bit( Block bits_ );
+
+	private:
+
+		static unsigned const BITS_PER_BLOCK =
+			boost::dynamic_bitset<>::bits_per_block;
+
+		unsigned m_dimension;
+		unsigned m_number_of_blocks;
+
+		// Rows of the echelon form stored one after another
+		std::vector< Block > m_rows;
+
+		// Row having the given pivot, or -1 if there is none
+		std::vector< int > m_pivot_rows;
+
+		std::vector< Block > m_buffer;
+	};
+
+	inline
+	Z2_basis::Z2_basis( unsigned dimension_ )
+		: m_dimension( dimension_ ),
+		m_number_of_blocks( ( dimension_ + BITS_PER_BLOCK - 1 ) / BITS_PER_BLOCK ),
+		m_pivot_rows( dimension_, -1 ), m_buffer( m_number_of_blocks )
+	{
+		m_rows.reserve( dimension_ * m_number_of_blocks );
+	}
+
+	inline unsigned
+	Z2_basis::dimension() const
+	{
+		return m_dimension;
+	}
+
+	inline unsigned
+	Z2_basis::rank() const
+	{
+		return m_number_of_blocks == 0 ? 0 : m_rows.size() / m_number_of_blocks;
+	}
+
+	inline bool
+	Z2_basis::insert( boost::dynamic_bitset<> const &bits_ )
+	{
+		assert( bits_.size() == m_dimension );
+
+		boost::to_block_range( bits_, m_buffer.begin() );
+
+		unsigned pivot( reduce() );
+		if ( pivot == m_dimension )
+			return false;
+
+		m_pivot_rows.at( pivot ) = rank();
+		m_rows.insert( m_rows.end(), m_buffer.begin(), m_buffer.end() );
+
+		return true;
+	}
+
+	inline bool
+	Z2_basis::is_independent( boost::dynamic_bitset<> const &bits_ )
+	{
+		assert( bits_.size() == m_dimension );
+
+		boost::to_block_range( bits_, m_buffer.begin() );
+
+		return reduce() != m_dimension;
+	}
+
+	inline void
+	Z2_basis::clear()
+	{
+		m_rows.clear();
+		m_pivot_rows.assign( m_dimension, -1 );
+	}
+
+	inline unsigned
+	Z2_basis::reduce()
+	{
+		for ( unsigned block( 0 ); block < m_number_of_blocks; )
+		{
+			Block bits( m_buffer[ block ] );
+			if ( bits == 0 )
+			{
+				++block;
+				continue;
+			}
+
+			unsigned pivot( block * BITS_PER_BLOCK + lowest_set_bit( bits ) );
+
+			int row( m_pivot_rows[ pivot ] );
+			if ( row == -1 )
+				return pivot;
+
+			// the row has no bits below its pivot, so the blocks before
+			// the current one are left untouched
+			xor_blocks( &m_buffer[ block ],
+				&m_rows[ row * m_number_of_blocks + block ],
+				m_number_of_blocks - block );
+		}
+
+		return m_dimension;
+	}
+
+	inline void
+	Z2_basis::xor_blocks( Block *p_destination_, Block const *p_source_,
+		unsigned size_ )
+	{
+		unsigned i( 0 );
+
+	#if defined( __SSE2__ )
+		unsigned const BLOCKS_PER_VECTOR( sizeof( __m128i ) / sizeof( Block ) );
+
+		for ( ; i + BLOCKS_PER_VECTOR <= size_; i += BLOCKS_PER_VECTOR )
+		{
+			__m128i destination( _mm_loadu_si128(
+				reinterpret_cast< __m128i const * >( p_destination_ + i ) ) );
+			__m128i source( _mm_loadu_si128(
+				reinterpret_cast< __m128i const * >( p_source_ + i ) ) );
+
+			_mm_storeu_si128( reinterpret_cast< __m128i * >( p_destination_ + i ),
+				_mm_xor_si128( destination, source ) );
+		}
+	#endif
+
+		for ( ; i < size_; ++i )
+			p_destination_[ i ] ^= p_source_[ i ];
+	}
+
+	inline unsigned
+	Z2_basis::lowest_set_bit( Block bits_ )
+	{
+		// the block is 32 bits wide on LLP64 platforms and 64 bits on LP64
+		// ones; either way it is widened without changing its low bits
+		static_assert( sizeof( Block ) <= sizeof( unsigned long long ),
+			"block wider than unsigned long long" );
+
+		assert( bits_ != 0 );
+		unsigned long long bits( bits_ );
+
+	#if defined( __GNUC__ )
+		return __builtin_ctzll( bits );
+	#elif defined( _MSC_VER )
+		unsigned long index;
+		if ( static_cast< unsigned long >( bits ) != 0 )
+		{
+			_BitScanForward( &index, static_cast< unsigned long >( bits ) );
+			return index;
+		}
+
+		_BitScanForward( &index, static_cast< unsigned long >( bits >> 32 ) );
+		return 32 + index;
+	#else
+		unsigned index( 0 );
+		for ( ; ( bits & 1 ) == 0; bits >>= 1 )
+			++index;
+
+		return index;
+	#endif
+	}
+}
+
+#endif // HEADERS_Z2_BASIS_H
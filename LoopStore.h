@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// THIS SOFTWARE IS PROVIDED "AS-IS". THERE IS NO WARRANTY OF ANY KIND.
+// NEITHER THE AUTHORS NOR THE OHIO STATE UNIVERSITY WILL BE LIABLE
+// FOR ANY DAMAGES OF ANY KIND, EVEN IF ADVISED OF SUCH POSSIBILITY.
+//
+// Copyright (c) 2010 Jyamiti Research Group.
+// CS&E Department of the Ohio State University, Columbus, OH.
+// All rights reserved.
+//
+// Author: Sayan Mandal
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _LOOP_STORE_H_
+#define _LOOP_STORE_H_
+
+#include <cassert>
+#include <map>
+#include <vector>
+
+/* Loops keyed by birth time, each given by the endpoints of its edges
+ * (a0 b0 a1 b1 ...). The endpoints of all loops are kept one after another
+ * in a single array, with an offsets table marking where each loop starts;
+ * coordinates are looked up from the point array only when needed.
+ * Erased loops leave a gap that is reclaimed once the gaps outweigh the
+ * loops still stored.
+ */
+class LoopStore
+{
+public:
+	typedef std::map<int, int>::const_iterator const_iterator;
+
+	LoopStore() : garbage(0)
+	{
+		offsets.push_back(0);
+	}
+	// endpoints has two entries per edge
+	bool insert(const int loop, const std::vector<int> &endpoints) {
+		if (!slots.insert(std::make_pair(loop, (int)offsets.size() - 1)).second)
+			return false;
+		data.insert(data.end(), endpoints.begin(), endpoints.end());
+		offsets.push_back((int)data.size());
+		return true;
+	}
+	void erase(const int loop) {
+		std::map<int, int>::iterator it = slots.find(loop);
+		if (it == slots.end())
+			return;
+		garbage += offsets[it->second + 1] - offsets[it->second];
+		slots.erase(it);
+		if (2 * garbage > (int)data.size())
+			compact();
+	}
+	bool contains(const int loop) const {
+		return slots.find(loop) != slots.end();
+	}
+	// the loop must be stored
+	int edge_count(const int loop) const {
+		assert(contains(loop));
+		int slot = slots.find(loop)->second;
+		return (offsets[slot + 1] - offsets[slot]) / 2;
+	}
+	const int *endpoints(const int loop) const {
+		assert(contains(loop));
+		return &data[offsets[slots.find(loop)->second]];
+	}
+	int size() const {
+		return (int)slots.size();
+	}
+	bool empty() const {
+		return slots.empty();
+	}
+	// iterates over ( loop, slot ) in the order of birth
+	const_iterator begin() const {
+		return slots.begin();
+	}
+	const_iterator end() const {
+		return slots.end();
+	}
+private:
+	void compact() {
+		std::vector<int> new_data;
+		std::vector<int> new_offsets;
+		new_data.reserve(data.size() - garbage);
+		new_offsets.reserve(slots.size() + 1);
+		new_offsets.push_back(0);
+		for (std::map<int, int>::iterator it = slots.begin(); it != slots.end(); ++it) {
+			new_data.insert(new_data.end(), data.begin() + offsets[it->second], data.begin() + offsets[it->second + 1]);
+			it->second = (int)new_offsets.size() - 1;
+			new_offsets.push_back((int)new_data.size());
+		}
+		data.swap(new_data);
+		offsets.swap(new_offsets);
+		garbage = 0;
+	}
+private:
+	std::vector<int> data;
+	// loop in slot s has endpoints data[offsets[s]] to data[offsets[s + 1] - 1]
+	std::vector<int> offsets;
+	std::map<int, int> slots;
+	int garbage;
+};
+
+#endif // _LOOP_STORE_H_
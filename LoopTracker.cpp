@@ -0,0 +1,145 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// THIS SOFTWARE IS PROVIDED "AS-IS". THERE IS NO WARRANTY OF ANY KIND.
+// NEITHER THE AUTHORS NOR THE OHIO STATE UNIVERSITY WILL BE LIABLE
+// FOR ANY DAMAGES OF ANY KIND, EVEN IF ADVISED OF SUCH POSSIBILITY.
+//
+// Copyright (c) 2010 Jyamiti Research Group.
+// CS&E Department of the Ohio State University, Columbus, OH.
+// All rights reserved.
+//
+// Author: Sayan Mandal
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LoopTracker.h"
+
+AnnotationVector LoopTracker::to_vector(const AnnotationColumnPtr &head) {
+	AnnotationVector anno;
+	if (head)
+		anno.assign(head->rows.begin(), head->rows.end());
+	return anno;
+}
+
+bool LoopTracker::is_independent(const AnnotationVector &anno) const {
+	AnnotationVector rest(anno);
+	while (!rest.empty()) {
+		std::map<int, Column>::const_iterator it = pivots.find(rest.back());
+		if (it == pivots.end())
+			return true;
+		add(rest, it->second.anno);
+	}
+	return false;
+}
+
+void LoopTracker::insert(const int loop, const AnnotationVector &anno) {
+	loops[loop] = anno;
+	Column col;
+	col.anno = anno;
+	col.loops.push_back(loop);
+	place(col);
+}
+
+void LoopTracker::erase(const int loop) {
+	if (loops.erase(loop) == 0)
+		return;
+	// Some column containing the loop is dropped after it is added to the
+	// others containing it. A zero sum is dropped if there is one; otherwise
+	// the column with the smallest pivot, so that the pivots of the columns
+	// it is added to do not change.
+	int dropped = -1;
+	for (size_t i = 0; i < dependencies.size() && dropped == -1; i++) {
+		if (contains(dependencies[i].loops, loop))
+			dropped = (int)i;
+	}
+	if (dropped != -1) {
+		Column col;
+		std::swap(col, dependencies[dropped]);
+		dependencies.erase(dependencies.begin() + dropped);
+		for (size_t i = 0; i < dependencies.size(); i++) {
+			if (contains(dependencies[i].loops, loop))
+				add(dependencies[i].loops, col.loops);
+		}
+		for (std::map<int, Column>::iterator it = pivots.begin(); it != pivots.end(); ++it) {
+			if (contains(it->second.loops, loop))
+				add(it->second.loops, col.loops);
+		}
+		return;
+	}
+	std::map<int, Column>::iterator itDropped = pivots.end();
+	for (std::map<int, Column>::iterator it = pivots.begin(); it != pivots.end(); ++it) {
+		if (!contains(it->second.loops, loop))
+			continue;
+		if (itDropped == pivots.end())
+			itDropped = it;
+		else
+			add(it->second, itDropped->second);
+	}
+	if (itDropped != pivots.end())
+		pivots.erase(itDropped);
+}
+
+void LoopTracker::kill_cocycle(const int simplex_dim, const int u, const AnnotationColumnPtr &sum) {
+	// loops are sums of edges
+	if (simplex_dim != 1)
+		return;
+	AnnotationVector anno_sum = to_vector(sum);
+	for (std::map<int, AnnotationVector>::iterator it = loops.begin(); it != loops.end(); ++it) {
+		if (contains(it->second, u))
+			add(it->second, anno_sum);
+	}
+	// zero sums stay zero; the other columns are placed again, as the ones
+	// with pivot u get a new pivot
+	std::vector<Column> changed;
+	std::map<int, Column>::iterator it = pivots.begin();
+	while (it != pivots.end()) {
+		if (contains(it->second.anno, u)) {
+			changed.push_back(Column());
+			std::swap(changed.back(), it->second);
+			add(changed.back().anno, anno_sum);
+			pivots.erase(it++);
+		}
+		else
+			++it;
+	}
+	for (size_t i = 0; i < changed.size(); i++)
+		place(changed[i]);
+}
+
+int LoopTracker::dead_loop() const {
+	for (std::map<int, AnnotationVector>::const_iterator it = loops.begin(); it != loops.end(); ++it) {
+		if (it->second.empty())
+			return it->first;
+	}
+	return -1;
+}
+
+void LoopTracker::add(std::vector<int> &dst, const std::vector<int> &src) {
+	std::vector<int> res;
+	res.reserve(dst.size() + src.size());
+	std::set_symmetric_difference(dst.begin(), dst.end(), src.begin(), src.end(), std::back_inserter(res));
+	dst.swap(res);
+}
+
+void LoopTracker::add(Column &dst, const Column &src) {
+	add(dst.anno, src.anno);
+	add(dst.loops, src.loops);
+}
+
+bool LoopTracker::contains(const std::vector<int> &v, const int x) {
+	return std::binary_search(v.begin(), v.end(), x);
+}
+
+void LoopTracker::place(Column &col) {
+	while (!col.anno.empty()) {
+		std::map<int, Column>::iterator it = pivots.find(col.anno.back());
+		if (it == pivots.end()) {
+			int pivot = col.anno.back();
+			std::swap(pivots[pivot], col);
+			return;
+		}
+		add(col, it->second);
+	}
+	dependencies.push_back(Column());
+	std::swap(dependencies.back(), col);
+}
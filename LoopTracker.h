@@ -0,0 +1,73 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// THIS SOFTWARE IS PROVIDED "AS-IS". THERE IS NO WARRANTY OF ANY KIND.
+// NEITHER THE AUTHORS NOR THE OHIO STATE UNIVERSITY WILL BE LIABLE
+// FOR ANY DAMAGES OF ANY KIND, EVEN IF ADVISED OF SUCH POSSIBILITY.
+//
+// Copyright (c) 2010 Jyamiti Research Group.
+// CS&E Department of the Ohio State University, Columbus, OH.
+// All rights reserved.
+//
+// Author: Sayan Mandal
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _LOOP_TRACKER_H_
+#define _LOOP_TRACKER_H_
+
+#include "SimplexNode.h"
+
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+
+// Z2 vector given by the sorted rows of its nonzero entries
+typedef std::vector<int> AnnotationVector;
+
+/* Annotations of the alive loops, kept up to date as cocycles are killed.
+ * Besides the annotation of every loop, the tracker keeps a column-reduced
+ * matrix of them keyed by pivot (lowest one), where every column remembers
+ * which loops it is the sum of. A new loop is then checked against the
+ * alive ones by reducing its annotation alone.
+ */
+class LoopTracker
+{
+public:
+	LoopTracker()
+	{}
+	// sorted rows of an annotation column of the annotation matrix
+	static AnnotationVector to_vector(const AnnotationColumnPtr &head);
+	// dst = dst + src over Z2
+	static void add(std::vector<int> &dst, const std::vector<int> &src);
+	// true if the annotation is not in the span of the alive loops
+	bool is_independent(const AnnotationVector &anno) const;
+	void insert(const int loop, const AnnotationVector &anno);
+	void erase(const int loop);
+	// the annotation matrix in dimension simplex_dim has added sum to every
+	// annotation with nonzero u-th bit; does the same to the tracked ones
+	void kill_cocycle(const int simplex_dim, const int u, const AnnotationColumnPtr &sum);
+	// some alive loop whose annotation is zero, or -1 if there is none
+	int dead_loop() const;
+	int size() const {
+		return (int)loops.size();
+	}
+private:
+	struct Column
+	{
+		AnnotationVector anno;
+		std::vector<int> loops;	// sorted ids of the loops summing to anno
+	};
+	static void add(Column &dst, const Column &src);
+	static bool contains(const std::vector<int> &v, const int x);
+	// reduces the column and stores it under its pivot, or among the
+	// dependencies if it reduced to zero
+	void place(Column &col);
+private:
+	std::map<int, AnnotationVector> loops;
+	std::map<int, Column> pivots;
+	// zero sums of alive loops
+	std::vector<Column> dependencies;
+};
+
+#endif // _LOOP_TRACKER_H_
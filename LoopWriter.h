@@ -0,0 +1,137 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// THIS SOFTWARE IS PROVIDED "AS-IS". THERE IS NO WARRANTY OF ANY KIND.
+// NEITHER THE AUTHORS NOR THE OHIO STATE UNIVERSITY WILL BE LIABLE
+// FOR ANY DAMAGES OF ANY KIND, EVEN IF ADVISED OF SUCH POSSIBILITY.
+//
+// Copyright (c) 2010 Jyamiti Research Group.
+// CS&E Department of the Ohio State University, Columbus, OH.
+// All rights reserved.
+//
+// Author: Sayan Mandal
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _LOOP_WRITER_H_
+#define _LOOP_WRITER_H_
+
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include <Point.h>
+
+/* Writes loops to OFF files, one file <folder><birth time>.off per loop,
+ * where every edge is drawn as a degenerate quad. Loops are handed over as
+ * soon as they die and written by a background thread, so the scan of the
+ * filtration does not wait for the disk; the queue between the two is
+ * bounded, and write() blocks while it is full.
+ */
+class LoopWriter
+{
+public:
+	LoopWriter(const std::string &folder, const std::vector<Point> &points, const int capacity = 64)
+		: folder(folder), points(points), capacity(capacity), done(false)
+	{
+		boost::filesystem::create_directory(boost::filesystem::path(folder.c_str()));
+		thread = boost::thread(&LoopWriter::run, this);
+	}
+	~LoopWriter()
+	{
+		finish();
+	}
+	// endpoints has two entries per edge
+	void write(const int loop, const int *endpoints, const int nEdges) {
+		boost::unique_lock<boost::mutex> lock(mutex);
+		while (jobs.size() >= capacity)
+			not_full.wait(lock);
+		jobs.push_back(Job());
+		jobs.back().loop = loop;
+		jobs.back().endpoints.assign(endpoints, endpoints + 2 * nEdges);
+		not_empty.notify_one();
+	}
+	// returns once every loop handed over has been written
+	void finish() {
+		{
+			boost::unique_lock<boost::mutex> lock(mutex);
+			done = true;
+			not_empty.notify_one();
+		}
+		if (thread.joinable())
+			thread.join();
+	}
+private:
+	struct Job
+	{
+		int loop;
+		std::vector<int> endpoints;
+	};
+	std::string file_name(const int loop) const {
+		return folder + std::to_string(loop) + ".off";
+	}
+	void run() {
+		std::string buffer;
+		while (true) {
+			Job job;
+			{
+				boost::unique_lock<boost::mutex> lock(mutex);
+				while (jobs.empty() && !done)
+					not_empty.wait(lock);
+				if (jobs.empty())
+					return;
+				job.loop = jobs.front().loop;
+				job.endpoints.swap(jobs.front().endpoints);
+				jobs.pop_front();
+				not_full.notify_one();
+			}
+			format(job, buffer);
+			std::string file = file_name(job.loop);
+			FILE *p_file = fopen(file.c_str(), "w");
+			if (p_file == NULL || fwrite(buffer.data(), 1, buffer.size(), p_file) != buffer.size())
+				std::cerr << "Cannot write loop file " << file << "\n";
+			if (p_file != NULL)
+				fclose(p_file);
+		}
+	}
+	// coordinates are printed as floats, the way they are read
+	void format(const Job &job, std::string &buffer) const {
+		int nEdges = (int)job.endpoints.size() / 2;
+		char line[128];
+		buffer.clear();
+		snprintf(line, sizeof(line), "OFF\n%d %d 0\n", 4 * nEdges, nEdges);
+		buffer += line;
+		for (int i = 0; i < nEdges; i++) {
+			const Point &a = points[job.endpoints[2 * i]];
+			const Point &b = points[job.endpoints[2 * i + 1]];
+			for (int rep = 0; rep < 2; rep++) {
+				snprintf(line, sizeof(line), "%g %g %g\n", (float)a.get_coord(0), (float)a.get_coord(1), (float)a.get_coord(2));
+				buffer += line;
+				snprintf(line, sizeof(line), "%g %g %g\n", (float)b.get_coord(0), (float)b.get_coord(1), (float)b.get_coord(2));
+				buffer += line;
+			}
+		}
+		for (int i = 0; i < nEdges; i++) {
+			snprintf(line, sizeof(line), "4 %d %d %d %d 1.0 1.0 0.0\n", 4 * i, 4 * i + 1, 4 * i + 2, 4 * i + 3);
+			buffer += line;
+		}
+	}
+private:
+	std::string folder;
+	const std::vector<Point> &points;
+	size_t capacity;
+	std::deque<Job> jobs;
+	bool done;
+	boost::mutex mutex;
+	boost::condition_variable not_empty;
+	boost::condition_variable not_full;
+	boost::thread thread;
+};
+
+#endif // _LOOP_WRITER_H_
@@ -13,7 +13,9 @@
 #include <set>
 #include <queue>
 #include <stack>
+#include <deque>
 #include <algorithm>
+#include <stdint.h>
 #include <boost/shared_ptr.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/pointer_cast.hpp>
@@ -21,7 +23,76 @@
 
 using namespace std;
 
-extern std::vector<std::unordered_map<int, pair<int, int>>> persistences;
+/*-----Persistence pairs---------*/
+// <birth, death> filtration steps of the classes of one dimension, indexed
+// by the time stamp of the class; death is -1 while the class is alive.
+// Time stamps are handed out in increasing order, so the pairs sit in
+// pages of consecutive time stamps; an erased pair leaves a tombstone and
+// a page is released once all its pairs are erased
+class PersistencePairs
+{
+public:
+	PersistencePairs()
+	{}
+	// adds or overwrites the pair of time stamp ts
+	void insert(const int ts, const int birth, const int death = -1) {
+		if (ts < 0)
+			return;
+		const size_t page = ts >> PAGE_BITS;
+		if (page >= pages.size()) {
+			pages.resize(page + 1);
+			live.resize(page + 1, 0);
+		}
+		if (pages[page].empty())
+			pages[page].assign(PAGE_SIZE, std::make_pair(TOMBSTONE, -1));
+		pair<int, int> &p = pages[page][ts & (PAGE_SIZE - 1)];
+		if (p.first == TOMBSTONE)
+			++live[page];
+		p = std::make_pair(birth, death);
+	}
+	// NULL if there is no pair with time stamp ts
+	pair<int, int> *find(const int ts) {
+		const size_t page = ts >> PAGE_BITS;
+		if (ts < 0 || page >= pages.size() || pages[page].empty())
+			return NULL;
+		pair<int, int> &p = pages[page][ts & (PAGE_SIZE - 1)];
+		return p.first == TOMBSTONE ? NULL : &p;
+	}
+	void erase(const int ts) {
+		pair<int, int> *p = find(ts);
+		if (p) {
+			p->first = TOMBSTONE;
+			release_if_empty(ts >> PAGE_BITS);
+		}
+	}
+	// writes the pairs of dead classes as "dim birth death" lines and drops
+	// them, which releases their pages; with bAll the pairs of the classes
+	// still alive are written too, with death -1
+	void flush(std::ostream &os, const int dim, const bool bAll = false) {
+		for (size_t page = 0; page < pages.size(); ++page) {
+			for (size_t i = 0; i < pages[page].size(); ++i) {
+				pair<int, int> &p = pages[page][i];
+				if (p.first != TOMBSTONE && (p.second >= 0 || bAll)) {
+					os << dim << " " << p.first << " " << p.second << "\n";
+					p.first = TOMBSTONE;
+					release_if_empty(page);
+				}
+			}
+		}
+	}
+private:
+	void release_if_empty(const size_t page) {
+		if (--live[page] == 0)
+			std::vector<pair<int, int> >().swap(pages[page]);
+	}
+private:
+	static const int TOMBSTONE = -2;
+	static const int PAGE_BITS = 10;
+	static const int PAGE_SIZE = 1 << PAGE_BITS;
+	std::vector<std::vector<pair<int, int> > > pages;
+	std::vector<int> live; // pairs without tombstone in each page
+};
+extern std::vector<PersistencePairs> persistences;
 extern float fThreshold;
 extern int filtration_step;
 extern int max_dimension;
@@ -30,23 +101,318 @@ extern vector<float> vecFiltrationScale;
 /*-----Simplicial Tree---------*/
 /* declaration of simpicial tree node*/
 class SimplicialTreeNode;
-/* shared pointer to simplicial tree node */
-typedef boost::shared_ptr<SimplicialTreeNode> SimplicialTreeNode_ptr;
+/* pointer to simplicial tree node
+ * nodes are owned by the node pool of their simplicial tree and freed with
+ * it, so the pointer does no reference counting; it starts out null and
+ * keeps the interface of the shared pointer it replaces */
+class SimplicialTreeNode_ptr
+{
+public:
+	SimplicialTreeNode_ptr() : p(NULL)
+	{}
+	SimplicialTreeNode_ptr(SimplicialTreeNode *in_p) : p(in_p)
+	{}
+	SimplicialTreeNode *operator->() const {
+		return p;
+	}
+	SimplicialTreeNode &operator*() const {
+		return *p;
+	}
+	SimplicialTreeNode *get() const {
+		return p;
+	}
+	void reset() {
+		p = NULL;
+	}
+	explicit operator bool() const {
+		return p != NULL;
+	}
+	bool operator==(const SimplicialTreeNode_ptr &rhs) const {
+		return p == rhs.p;
+	}
+	bool operator!=(const SimplicialTreeNode_ptr &rhs) const {
+		return p != rhs.p;
+	}
+	bool operator<(const SimplicialTreeNode_ptr &rhs) const {
+		return p < rhs.p;
+	}
+private:
+	SimplicialTreeNode *p;
+};
+inline std::size_t hash_value(const SimplicialTreeNode_ptr &ptr) {
+	return boost::hash<SimplicialTreeNode *>()(ptr.get());
+}
+namespace std {
+	template<> struct hash<SimplicialTreeNode_ptr> {
+		std::size_t operator()(const SimplicialTreeNode_ptr &ptr) const {
+			return std::hash<SimplicialTreeNode *>()(ptr.get());
+		}
+	};
+}
+
+/* children of a simplicial tree node keyed by vertex label
+ * most nodes have a handful of children, which are kept as a sorted array
+ * and scanned in order; once a node has more than LINEAR_LIMIT
+ * children they move to an open-addressing table with linear probing.
+ * Labels are nonnegative, negative keys mark the free slots of the table.
+ * The limit is a power of two; bench/children_find.cpp measures it */
+#ifndef SIMPLICIAL_TREE_CHILDREN_LINEAR_LIMIT
+#define SIMPLICIAL_TREE_CHILDREN_LINEAR_LIMIT 2
+#endif
+class SimplicialTreeChildren
+{
+public:
+	typedef std::pair<int, SimplicialTreeNode_ptr> value_type;
+	class iterator
+	{
+	public:
+		iterator() : p(NULL), p_end(NULL)
+		{}
+		iterator(value_type *in_p, value_type *in_end) : p(in_p), p_end(in_end) {
+			skip();
+		}
+		value_type &operator*() const {
+			return *p;
+		}
+		value_type *operator->() const {
+			return p;
+		}
+		iterator &operator++() {
+			++p;
+			skip();
+			return *this;
+		}
+		iterator operator++(int) {
+			iterator it(*this);
+			++*this;
+			return it;
+		}
+		bool operator==(const iterator &rhs) const {
+			return p == rhs.p;
+		}
+		bool operator!=(const iterator &rhs) const {
+			return p != rhs.p;
+		}
+	private:
+		void skip() {
+			while (p != p_end && p->first < 0)
+				++p;
+		}
+		value_type *p;
+		value_type *p_end;
+	};
+
+	SimplicialTreeChildren() : count(0), used(0), shift(0)
+	{}
+	iterator begin() {
+		return iterator(slots.data(), slots.data() + slots.size());
+	}
+	iterator end() {
+		return iterator(slots.data() + slots.size(), slots.data() + slots.size());
+	}
+	int size() const {
+		return count;
+	}
+	bool empty() const {
+		return count == 0;
+	}
+	void clear() {
+		slots.clear();
+		count = used = shift = 0;
+	}
+	iterator find(const int label) {
+		int pos = shift == 0 ? sorted_find(label) : hashed_find(label);
+		if (pos < 0)
+			return end();
+		return iterator(slots.data() + pos, slots.data() + slots.size());
+	}
+	// inserts a null child if there is none with the label
+	SimplicialTreeNode_ptr &operator[](const int label) {
+		if (shift == 0) {
+			std::vector<value_type>::iterator it = std::lower_bound(slots.begin(), slots.end(), label, less_label);
+			if (it != slots.end() && it->first == label)
+				return it->second;
+			if (count < LINEAR_LIMIT) {
+				++count;
+				return slots.insert(it, value_type(label, SimplicialTreeNode_ptr()))->second;
+			}
+			rehash(2 * LINEAR_LIMIT);
+		}
+		int pos = hashed_find(label);
+		if (pos >= 0)
+			return slots[pos].second;
+		if (2 * (used + 1) > (int)slots.size()) {
+			// grow only if the children, and not the erased slots, fill the table
+			rehash(4 * (count + 1) > (int)slots.size() ? 2 * (int)slots.size() : (int)slots.size());
+		}
+		pos = hashed_slot(label);
+		if (slots[pos].first == EMPTY)
+			++used;
+		++count;
+		slots[pos].first = label;
+		return slots[pos].second;
+	}
+	int erase(const int label) {
+		if (shift == 0) {
+			int pos = sorted_find(label);
+			if (pos < 0)
+				return 0;
+			slots.erase(slots.begin() + pos);
+			--count;
+			return 1;
+		}
+		int pos = hashed_find(label);
+		if (pos < 0)
+			return 0;
+		slots[pos] = value_type(ERASED, SimplicialTreeNode_ptr());
+		--count;
+		return 1;
+	}
+private:
+	static const int LINEAR_LIMIT = SIMPLICIAL_TREE_CHILDREN_LINEAR_LIMIT;
+	static const int EMPTY = -1;
+	static const int ERASED = -2;
+	static bool less_label(const value_type &child, const int label) {
+		return child.first < label;
+	}
+	int sorted_find(const int label) const {
+		for (int pos = 0; pos < count; pos++) {
+			if (slots[pos].first >= label)
+				return slots[pos].first == label ? pos : -1;
+		}
+		return -1;
+	}
+	int home(const int label) const {
+		return (int)(((unsigned)label * 2654435769u) >> shift);
+	}
+	int hashed_find(const int label) const {
+		int mask = (int)slots.size() - 1;
+		for (int pos = home(label); slots[pos].first != EMPTY; pos = (pos + 1) & mask) {
+			if (slots[pos].first == label)
+				return pos;
+		}
+		return -1;
+	}
+	// first free slot on the probe sequence of a label not in the table
+	int hashed_slot(const int label) const {
+		int mask = (int)slots.size() - 1;
+		int pos = home(label);
+		while (slots[pos].first >= 0)
+			pos = (pos + 1) & mask;
+		return pos;
+	}
+	// capacity is a power of two
+	void rehash(const int capacity) {
+		std::vector<value_type> old_slots(capacity, value_type(EMPTY, SimplicialTreeNode_ptr()));
+		old_slots.swap(slots);
+		shift = 32;
+		for (int c = capacity; c > 1; c >>= 1)
+			--shift;
+		used = 0;
+		for (size_t i = 0; i < old_slots.size(); i++) {
+			if (old_slots[i].first >= 0) {
+				slots[hashed_slot(old_slots[i].first)] = old_slots[i];
+				++used;
+			}
+		}
+	}
+private:
+	// sorted children while shift is 0, the hash table otherwise
+	std::vector<value_type> slots;
+	int count;
+	// slots of the table that are not EMPTY
+	int used;
+	int shift;
+};
 
 /*-----Annotation Matrix classes---------*/
-class ListNode;
-// boost shared pointer to the list node 
-typedef boost::shared_ptr<ListNode> ListNodePtr;
-//typedef boost::weak_ptr<ListNode> ListNodeWeakPtr;
+class AnnotationColumn;
+// boost shared pointer to the annotation column
+typedef boost::shared_ptr<AnnotationColumn> AnnotationColumnPtr;
 /*------------------------------------------------*/
 
 /*--------union find deletion classes--------*/
-class TreeNode;
-class TreeRootNode;
-
-typedef boost::shared_ptr<SimplicialTreeNode> ElementNodePtr;
-typedef boost::shared_ptr<TreeNode> TreeNodePtr;
-typedef boost::shared_ptr<TreeRootNode> TreeRootNodePtr;
+typedef SimplicialTreeNode_ptr ElementNodePtr;
+// index of a tree node in the union-find-deletion forest; 0 is null
+typedef uint32_t TreeIndex;
+// links of a tree node, all by index
+class TreeNode
+{
+public:
+	TreeNode() : parent(0), cListHead(0), cPrev(0), cNext(0), nPrev(0), nNext(0),
+		dfsPrev(0), dfsNext(0), nListHead(0), cListSize(0), rank(0)
+	{}
+public:
+	TreeIndex parent;
+	TreeIndex cListHead; // children list head
+	TreeIndex cPrev; // previous in its siblings list 
+	TreeIndex cNext; // next in its siblings list
+	TreeIndex nPrev;
+	TreeIndex nNext;
+	TreeIndex dfsPrev;
+	TreeIndex dfsNext;
+	TreeIndex nListHead; // only used by roots
+	int cListSize;
+	int rank;
+};
+// the nodes of a union-find-deletion forest: the links of node i are
+// nodes[i], its element elem[i] and, for a root, the annotation of its
+// class attribute[i]. Slot 0 is unused, deleted nodes are reused
+class TreeForest
+{
+public:
+	TreeForest() : nodes(1), elem(1), attribute(1)
+	{}
+public:
+	std::vector<TreeNode> nodes;
+	std::vector<ElementNodePtr> elem;
+	std::vector<AnnotationColumnPtr> attribute;
+	std::vector<TreeIndex> free_nodes;
+};
+/* handle of a tree node
+ * keeps the interface of the shared pointer it replaces: the element and
+ * the annotation of a node are reached by ->elem and ->attribute */
+class TreeNodePtr
+{
+public:
+	struct Fields
+	{
+		ElementNodePtr &elem;
+		AnnotationColumnPtr &attribute;
+	};
+	struct Arrow
+	{
+		Fields fields;
+		Fields *operator->() {
+			return &fields;
+		}
+	};
+	TreeNodePtr() : forest(NULL), index(0)
+	{}
+	TreeNodePtr(TreeForest *in_forest, const TreeIndex in_index) : forest(in_forest), index(in_index)
+	{}
+	Arrow operator->() const {
+		Arrow arrow = { { forest->elem[index], forest->attribute[index] } };
+		return arrow;
+	}
+	void reset() {
+		forest = NULL;
+		index = 0;
+	}
+	explicit operator bool() const {
+		return index != 0;
+	}
+	bool operator==(const TreeNodePtr &rhs) const {
+		return index == rhs.index && forest == rhs.forest;
+	}
+	bool operator!=(const TreeNodePtr &rhs) const {
+		return !(*this == rhs);
+	}
+public:
+	TreeForest *forest;
+	TreeIndex index;
+};
+typedef TreeNodePtr TreeRootNodePtr;
 /*------------------------------------------------*/
 typedef std::vector<std::vector<SimplicialTreeNode_ptr>> TreeLoopTracker_ptr;
 
@@ -63,48 +429,23 @@ public:
 	int label;
 	int index_in_filtration;
 	SimplicialTreeNode_ptr parent;
-	std::unordered_map<int, SimplicialTreeNode_ptr> children;
+	SimplicialTreeChildren children;
 	SimplicialTreeNode_ptr next_circular_ptr;
 	SimplicialTreeNode_ptr prev_circular_ptr;
 	/*By convention, a simplex with zero annotation has a nullptr tree_node */
 	TreeNodePtr tree_node; // linked to the element used in the union-find-delete data struture;
 	int iStatus;	//0 means the simplex is uncovered by spanning tree
 };
+// nodes of a simplicial tree; a deque never moves its elements, and frees
+// them in large blocks
+typedef std::deque<SimplicialTreeNode> SimplicialTreeNodePool;
 
 /*************Union Find Deletion*********************************/
-class TreeNode
-{
-public:
-	TreeNode() : cListSize(0), rank(0)
-	{}
-public:
-	ElementNodePtr elem;
-	TreeNodePtr parent;
-	TreeNodePtr cListHead; // children list head pointer
-	TreeNodePtr cPrev; // previous pointer in its siblings list 
-	TreeNodePtr cNext; // next pointer in its siblings list
-	TreeNodePtr nPrev;
-	TreeNodePtr nNext;
-	TreeNodePtr dfsPrev;
-	TreeNodePtr dfsNext;
-	int cListSize;
-	int rank;
-};
-
-class TreeRootNode : public TreeNode
-{
-public:
-	TreeRootNode() : TreeNode()
-	{}
-public:
-	TreeNodePtr nListHead;
-	boost::shared_ptr<ListNode> attribute;
-};
-
-
 class UnionFindDeletion
 {
 public:
+	UnionFindDeletion() : forest(boost::make_shared<TreeForest>())
+	{}
 	~UnionFindDeletion()
 	{
 		//std::cout << "Deconstructor" << std::endl; 
@@ -115,119 +456,107 @@ public:
 	void Delete(TreeNodePtr  a);
 	bool Is_singleton(TreeNodePtr a) {
 		TreeRootNodePtr root = Find(a);
-		return !(root->cListHead);
+		return !(node(root.index).cListHead);
 	}
 	// 
 	//public:
 private:
-	TreeRootNodePtr find_root(TreeNodePtr a){
-		while (a->parent != a) {
-			a = a->parent;
+	TreeNode &node(const TreeIndex a) {
+		return forest->nodes[a];
+	}
+	TreeNodePtr handle(const TreeIndex a) {
+		return TreeNodePtr(forest.get(), a);
+	}
+	TreeIndex find_root(TreeIndex a){
+		while (node(a).parent != a) {
+			a = node(a).parent;
 		}
-		return boost::static_pointer_cast<TreeRootNode>(a);
+		return a;
 	}
-	void link_tree_node_and_element(TreeNodePtr a, ElementNodePtr b)
+	void link_tree_node_and_element(TreeIndex a, ElementNodePtr b)
 	{//a<------>b
-		a->elem = b;
-		b->tree_node = a;
+		forest->elem[a] = b;
+		b->tree_node = handle(a);
 		return;
 	}
-	void unlink_tree_node_and_element(TreeNodePtr a, ElementNodePtr b)
+	void unlink_tree_node_and_element(TreeIndex a, ElementNodePtr b)
 	{//a<---x--->b
-		a->elem.reset();
+		forest->elem[a].reset();
 		b->tree_node.reset();
 		return;
 	}
-	void LinkSingleNodeToTreeRoot(TreeNodePtr a, TreeRootNodePtr &T);
-	void insert_into_nlist(TreeNodePtr a, TreeRootNodePtr &T);
-	void insert_into_clist_and_dfs_list(TreeNodePtr elem, TreeNodePtr parent);
-	void Relink(TreeNodePtr a);
-	void LocalRebuild(TreeNodePtr &p);
-	void RemoveFromDFSList(TreeNodePtr a);
-	void RemoveFromCList(TreeNodePtr a);
-	void RemoveFromNList(TreeNodePtr a);
-	void InsertIntoCList(TreeNodePtr p, TreeNodePtr ref, TreeNodePtr a, bool right);
-	void InsertIntoNList(TreeRootNodePtr p, TreeNodePtr ref, TreeNodePtr a);
-	void DeleteFromReducedTree(TreeNodePtr a);
+	TreeIndex new_node();
+	void free_node(TreeIndex a);
+	void LinkSingleNodeToTreeRoot(TreeIndex a, TreeIndex T);
+	void insert_into_nlist(TreeIndex a, TreeIndex T);
+	void insert_into_clist_and_dfs_list(TreeIndex elem, TreeIndex parent);
+	void Relink(TreeIndex a);
+	void LocalRebuild(TreeIndex p);
+	void RemoveFromDFSList(TreeIndex a);
+	void RemoveFromCList(TreeIndex a);
+	void RemoveFromNList(TreeIndex a);
+	void InsertIntoCList(TreeIndex p, TreeIndex ref, TreeIndex a, bool right);
+	void InsertIntoNList(TreeIndex p, TreeIndex ref, TreeIndex a);
+	void DeleteFromReducedTree(TreeIndex a);
+private:
+	// shared by copies, like the nodes of the simplicial tree
+	boost::shared_ptr<TreeForest> forest;
 };
 /**********Annotation matrix***************************/
-// Each column in the annotation matrix is a circular list with a dummy head
-//// dummy head with row index -1
-// such that all row elements are doublely linked 
-class ListNode
+// Each column in the annotation matrix is the sorted array of the rows of
+// its nonzero entries (all entries are 1 over Z2). A column stored in the
+// matrix also knows its position in the member list of each of its rows.
+// The hash of a column is the xor of the keys of its rows, so the hash of
+// a sum is the xor of the hashes
+class AnnotationColumn
 {
 public:
-	ListNode() : row(-1), val(0)
-	{// dummy head with row index -1
-	}
-	ListNode(const ListNode &rhs);
-	ListNode& operator=(const ListNode &rhs);
-	ListNode(const int r, const int v) : row(r), val(v)
+	AnnotationColumn() : hash(0)
 	{}
-	//
-	void RowConnections(ListNodePtr &r, ListNodePtr &l){
-		right = r;
-		left = l;
-		return;
+	AnnotationColumn(const uint32_t r) : rows(1, r), hash(row_key(r))
+	{}
+	bool empty() const {
+		return rows.empty();
+	}
+	// appends a row larger than all rows of the column
+	void push_back(const uint32_t r) {
+		rows.push_back(r);
+		hash ^= row_key(r);
 	}
-	void ResetRowPtrs() {
-		right.reset();
-		left.reset();
+	// pseudo-random key of a row (splitmix64 finalizer)
+	static uint64_t row_key(const uint32_t r) {
+		uint64_t z = r + 0x9e3779b97f4a7c15ULL;
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		return z ^ (z >> 31);
 	}
 public:
-	int row; // the row 
-	int val; // entry value
-	ListNodePtr next; // pointer to next element in the column
-	ListNodePtr right; // pointer to its right element in the row
-	ListNodePtr left; // pointer to its left element int the row
+	std::vector<uint32_t> rows; // rows of the nonzero entries, increasing
+	std::vector<uint32_t> slots; // slots[i]: position in the member list of rows[i]
+	uint64_t hash; // xor of row_key over rows
 };
-// hash function for ListNodePtr
-struct hash_ListNodePtr
+// hash function for AnnotationColumnPtr
+struct hash_AnnotationColumnPtr
 {
-	std::size_t operator() (const ListNodePtr &  nodePtr) const
+	std::size_t operator() (const AnnotationColumnPtr &  col) const
 	{
-		std::size_t s = 0;
-		/*ignore the dummy node [nodePtr]*/
-		ListNodePtr p(nodePtr->next);
 		// zero annotation has hash value 0
-		while (p != nodePtr)
-		{
-			boost::hash_combine(s, p->row);
-			boost::hash_combine(s, p->val);
-			//
-			p = p->next;
-		}
-		return s;
+		return (std::size_t)col->hash;
 	}
 };
-struct equal_ListNodePtr {
-	bool operator() (const ListNodePtr   lhs, const ListNodePtr   rhs) const {
-		/*ignore the dummy node [lhs] [rhs]*/
-		ListNodePtr p(lhs->next);
-		ListNodePtr q(rhs->next);
-		if (p == lhs && q == rhs) {
-			// both are zero annotation
-			return true;
-		}
-		if (p == lhs && q != rhs || q == rhs && p != lhs) {
-			// one is zero and the other is not zero
-			return false;
-		}
-		while (p != lhs && q != rhs) {
-			if (p->row != q->row) {
-				return false;
-			}
-			p = p->next;
-			q = q->next;
-		}
-		return ((p == lhs) && (q == rhs));
+struct equal_AnnotationColumnPtr {
+	bool operator() (const AnnotationColumnPtr   lhs, const AnnotationColumnPtr   rhs) const {
+		// compare the rows only if the hashes agree
+		return lhs == rhs || (lhs->hash == rhs->hash && lhs->rows == rhs->rows);
 	}
 };
+// columns with a nonzero entry in a row
+typedef std::vector<AnnotationColumnPtr> AnnotationRowMembers;
 //
 class AnnotationMatrix
 {
-	/*ListNodePtr == nullptr indicates the zero annotation*/
-	/* each column is a list with a dummy head node */
+	/*AnnotationColumnPtr == nullptr indicates the zero annotation*/
+	/* each column is a sorted array of rows */
 public:
 	AnnotationMatrix() : timeStamp(0)
 	{}
@@ -238,39 +567,37 @@ public:
 	{
 
 	}
-	ListNodePtr DeepCopyAnnotationColumn(const ListNodePtr &head);
+	AnnotationColumnPtr DeepCopyAnnotationColumn(const AnnotationColumnPtr &head);
 	// 
-	bool search(ListNodePtr &ptr) {
+	bool search(AnnotationColumnPtr &ptr) {
 		return (ann_mat.find(ptr) != ann_mat.end());
 	}
-	TreeRootNodePtr tree_root(ListNodePtr &ptr) {
+	TreeRootNodePtr tree_root(AnnotationColumnPtr &ptr) {
 		if (ann_mat.find(ptr) != ann_mat.end()) {
 			return ann_mat[ptr];
 		}
 		return TreeRootNodePtr();
 	}
-	void update_tree_root(ListNodePtr &ptr, TreeRootNodePtr &root) {
+	void update_tree_root(AnnotationColumnPtr &ptr, TreeRootNodePtr &root) {
 		ann_mat[ptr] = root;
 		return;
 	}
-	ListNodePtr make_zero_annotation() {
-		ListNodePtr p(boost::make_shared<ListNode>());
-		p->next = p;
-		return p;
+	AnnotationColumnPtr make_zero_annotation() {
+		return boost::make_shared<AnnotationColumn>();
 	}
-	void Insert(ListNodePtr &ptr, const TreeRootNodePtr x, UnionFindDeletion &ufd);
-	TreeRootNodePtr Delete(ListNodePtr &ptr);
-	void clearNode(ListNodePtr &ptr, bool bUpdatePers = true);
-	ListNodePtr extract_column(ListNodePtr & head) {
+	void Insert(AnnotationColumnPtr &ptr, const TreeRootNodePtr x, UnionFindDeletion &ufd);
+	TreeRootNodePtr Delete(AnnotationColumnPtr &ptr);
+	void clearNode(AnnotationColumnPtr &ptr, bool bUpdatePers = true);
+	AnnotationColumnPtr extract_column(AnnotationColumnPtr & head) {
 		if (head) {
-			ListNodePtr col_head = DeepCopyAnnotationColumn(head);
+			AnnotationColumnPtr col_head = DeepCopyAnnotationColumn(head);
 			//Delete(head);
 			clearNode(head, false);
 			return col_head;
 		}
-		return ListNodePtr();
+		return AnnotationColumnPtr();
 	}
-	int sum_dst_with_one_column(ListNodePtr &out_dst, ListNodePtr &in_src) {
+	int sum_dst_with_one_column(AnnotationColumnPtr &out_dst, AnnotationColumnPtr &in_src) {
 		if (search(in_src)) {
 			return sum_two_annotation_with_changed_dst(out_dst, in_src);
 		}
@@ -279,63 +606,63 @@ public:
 	int genus() {
 		return (int)row_ptr.size();
 	}
-	ListNodePtr create_cocycle(TreeRootNodePtr &root, UnionFindDeletion &ufd, bool zero_elem = false);
-	int sum_two_annotation_with_changed_dst(ListNodePtr & out_dst, ListNodePtr & in_src);
-	int lowest_one(ListNodePtr & head);
-	void kill_cocycle_last_nonzero_bit(const int u, ListNodePtr &ext_src, UnionFindDeletion &ufd);
+	AnnotationColumnPtr create_cocycle(TreeRootNodePtr &root, UnionFindDeletion &ufd, bool zero_elem = false);
+	int sum_two_annotation_with_changed_dst(AnnotationColumnPtr & out_dst, AnnotationColumnPtr & in_src);
+	int lowest_one(AnnotationColumnPtr & head);
+	void kill_cocycle_last_nonzero_bit(const int u, AnnotationColumnPtr &ext_src, UnionFindDeletion &ufd);
 	bool empty() {
 		return ann_mat.empty();
 	}
 public:
-	std::unordered_map<ListNodePtr, TreeRootNodePtr, hash_ListNodePtr, equal_ListNodePtr> ann_mat;
-	std::unordered_map<int, ListNodePtr> row_ptr;
+	std::unordered_map<AnnotationColumnPtr, TreeRootNodePtr, hash_AnnotationColumnPtr, equal_AnnotationColumnPtr> ann_mat;
+	// the columns of ann_mat with a nonzero entry in each nonzero row
+	std::unordered_map<int, AnnotationRowMembers> row_ptr;
 	long long timeStamp;		//always stores the next coming time stamp
 	int annoDim;  //dimension of the simplices this annotation matrix is for
 private:
-	void delete_from_doubly_linked_list(const int row, ListNodePtr & p, bool bUpdatePers = true) {
-		if (p->left == p) {
+	// scratch space of sum_two_annotation_with_changed_dst
+	std::vector<uint32_t> sum_buffer;
+	std::vector<uint32_t> slot_buffer;
+private:
+	// adds src to a column kept in the member lists of its rows, except
+	// for row u whose list is dropped by the caller; only the rows that
+	// change are updated
+	void add_to_stored_column(AnnotationColumnPtr &col, const AnnotationColumnPtr &src, const int u);
+	// removes the column from the members of its i-th row
+	void delete_from_row(AnnotationColumnPtr & p, const int i, bool bUpdatePers = true) {
+		const int row = p->rows[i];
+		std::unordered_map<int, AnnotationRowMembers>::iterator findIter = row_ptr.find(row);
+		AnnotationRowMembers &members = findIter->second;
+		if (members.size() == 1) {
 			// it is the last element
-			row_ptr[row].reset();
-			row_ptr.erase(row);
+			row_ptr.erase(findIter);
 			if (bUpdatePers && annoDim <= max_dimension)
 			{
 				//update persistences in dim annoDim
-				unordered_map<int, pair<int, int>>::iterator iterPers = persistences[annoDim].find(row);
-				(iterPers->second).second = filtration_step;
-				float diff = vecFiltrationScale[filtration_step] - vecFiltrationScale[(iterPers->second).first];
+				pair<int, int> *iterPers = persistences[annoDim].find(row);
+				iterPers->second = filtration_step;
+				float diff = vecFiltrationScale[filtration_step] - vecFiltrationScale[iterPers->first];
 				if (diff <= fThreshold && diff >= 0)
-					persistences[annoDim].erase(iterPers);
+					persistences[annoDim].erase(row);
 			}
+			return;
 		}
-		else {
-			// not last element
-			if (p == row_ptr[row]) {
-				// the head 
-				row_ptr[row] = p->left;
-			}
-			p->left->right = p->right;
-			p->right->left = p->left;
+		// not last element; the last member takes its slot
+		const uint32_t slot = p->slots[i];
+		if (slot + 1 != members.size()) {
+			AnnotationColumnPtr &last = members.back();
+			std::vector<uint32_t>::iterator it = std::lower_bound(last->rows.begin(), last->rows.end(), (uint32_t)row);
+			last->slots[it - last->rows.begin()] = slot;
+			members[slot].swap(last);
 		}
-		//
-		p->left.reset();
-		p->right.reset();
+		members.pop_back();
 		return;
 	}
-	void insert_into_doubly_linked_list(const int row, ListNodePtr & p) {
-		std::unordered_map<int, ListNodePtr>::iterator findIter = row_ptr.find(row);
-		if (findIter != row_ptr.end())
-		{// insert behind the head
-			p->left = findIter->second->left;
-			p->right = findIter->second;
-			p->left->right = p;
-			findIter->second->left = p;
-		}
-		else
-		{// the first one
-			row_ptr[p->row] = p;
-			p->left = p;
-			p->right = p;
-		}
+	// adds the column to the members of its i-th row
+	void insert_into_row(AnnotationColumnPtr & p, const int i) {
+		AnnotationRowMembers &members = row_ptr[p->rows[i]];
+		p->slots[i] = (uint32_t)members.size();
+		members.push_back(p);
 		return;
 	}
 };
@@ -2,6 +2,8 @@
 (c) 2015 Fengtao Fan, Dayu Shi
 */
 #include "SimplicialComplex.h"
+#include "LoopTracker.h"
+#include "LoopStore.h"
 #include <fstream>
 #include <sstream>
 #include <string>
@@ -9,7 +11,7 @@
 
 using namespace std;
 
-std::vector<std::unordered_map<int, pair<int, int>>> persistences;
+std::vector<PersistencePairs> persistences;
 int filtration_step;
 int time_in_each_filtration_step;
 SimplicialTree<bool> domain_complex;
@@ -85,11 +87,10 @@ void ComputingPersistenceForSimplicialMap(const char* file_name_of_domain_comple
 			///////////////first step in filtration, check born time of each homology class
 			for (int i = 0; i < homo_info.size(); ++i)
 			{
-				std::unordered_map<int, pair<int, int>> vecEmp;
-				persistences.push_back(vecEmp);
+				persistences.push_back(PersistencePairs());
 				for (::unordered_set<int>::iterator it = homo_info[i].begin(); it != homo_info[i].end(); ++it)
 				{
-					persistences[i][*it] = std::make_pair(0, -1);
+					persistences[i].insert(*it, 0);
 				}
 			}
 		}
@@ -141,11 +142,10 @@ void ComputingPersistenceForSimplicialMapElementary(vector<vector<int> > simplex
 				///////////////first step in filtration, check born time of each homology class
 				for (int i = 0; i < homo_info.size(); ++i)
 				{
-					std::unordered_map<int, pair<int, int>> vecEmp;
-					persistences.push_back(vecEmp);
+					persistences.push_back(PersistencePairs());
 					for (::unordered_set<int>::iterator it = homo_info[i].begin(); it != homo_info[i].end(); ++it)
 					{
-						persistences[i][*it] = std::make_pair(0, -1);
+						persistences[i].insert(*it, 0);
 					}
 				}
 			}
@@ -159,17 +159,10 @@ void ComputingPersistenceForSimplicialMapElementary(vector<vector<int> > simplex
 	}
 
 	bool flag = false;
-	for(int count=0;count<simplexIns.size();count++){
-
-		std::vector<int> interm = simplexIns.at(count);
-		timer1 = std::clock();
-
-		domain_complex.ElementaryInsersion(interm);
-		
-
-		interm.clear();
-		dInsertTime += std::clock() - timer1;
-	}
+	// all the simplices come in this filtration step
+	timer1 = std::clock();
+	domain_complex.InsertBatch(simplexIns);
+	dInsertTime += std::clock() - timer1;
 
 	if (is_save_range_complex_with_annotation) {
 		domain_complex.WriteComplexWithAnnotation(new_range_complex_file_name);
@@ -197,7 +190,7 @@ void ComputingPersistenceForSimplicialMapElementary(vector<vector<int> > simplex
 
 
 
-ListNodePtr AddBoundary(std::vector<std::vector<int>> simplex_vertices){
+AnnotationColumnPtr AddBoundary(std::vector<std::vector<int>> simplex_vertices){
 // For each cycle
 // outer vector: stores edges
 	vector<SimplicialTreeNode_ptr> cyclic_edges;	
@@ -212,19 +205,19 @@ ListNodePtr AddBoundary(std::vector<std::vector<int>> simplex_vertices){
 	// cout<<"Loop Sum:\n";
 	SimplicialTreeNode_ptr simplex ;
 	simplex = domain_complex.find(simplex_vertices.at(0));	//get one edge
-	ListNodePtr p = domain_complex.find_annotation(simplex);
-	ListNodePtr sum = domain_complex.annotations[sizes]->DeepCopyAnnotationColumn(domain_complex.find_annotation(simplex));
+	AnnotationColumnPtr p = domain_complex.find_annotation(simplex);
+	AnnotationColumnPtr sum = domain_complex.annotations[sizes]->DeepCopyAnnotationColumn(domain_complex.find_annotation(simplex));
 	int dead_bit = -1;
 	// simplex.clear();
 	for(int i=1;i<simplex_vertices.size();i++){
 	// SimplicialTreeNode_ptr simplex ;
 	simplex = domain_complex.find(simplex_vertices.at(i));	//get one edge
-	ListNodePtr tempLNP = domain_complex.annotations[sizes]->DeepCopyAnnotationColumn(domain_complex.find_annotation(simplex));
+	AnnotationColumnPtr tempLNP = domain_complex.annotations[sizes]->DeepCopyAnnotationColumn(domain_complex.find_annotation(simplex));
 	dead_bit = domain_complex.annotations[sizes]->sum_two_annotation_with_changed_dst(sum, tempLNP);
 	}
 	
 
-	// ListNodePtr trav(sum->next);
+	// AnnotationColumnPtr trav(sum->next);
 	// 	cout << "[";
 	// 	while (trav != sum) {
 	// 		cout << "<" << trav->row << " " << 1 << ">" << (trav->next == sum ? "" : " ");
@@ -239,16 +232,11 @@ ListNodePtr AddBoundary(std::vector<std::vector<int>> simplex_vertices){
 		return sum;
 }//end of addboundary
 
-int LowReturner(ListNodePtr sum){
-
-	ListNodePtr trav(sum->next);
+int LowReturner(AnnotationColumnPtr sum){
 
-	while (trav != sum) {
-		if(trav->next==sum)
-			return trav->row;
-			trav = trav->next;
-		}
+	if(sum->empty())
 		return -1;
+	return sum->rows.back();
 }
 
 
@@ -259,93 +247,59 @@ int lowfromHigherOrder(higherOrder &simplex_vertices){
 	SimplicialTreeNode_ptr simplex ;
 	int sizes = 1;
 	simplex = domain_complex.find(simplex_vertices.at(0));	//get one edge
-	ListNodePtr p = domain_complex.find_annotation(simplex);
-	ListNodePtr sum = domain_complex.annotations[sizes]->DeepCopyAnnotationColumn(domain_complex.find_annotation(simplex));
+	AnnotationColumnPtr p = domain_complex.find_annotation(simplex);
+	AnnotationColumnPtr sum = domain_complex.annotations[sizes]->DeepCopyAnnotationColumn(domain_complex.find_annotation(simplex));
 	int dead_bit = -1;
 	// simplex.clear();
 	for(int i=1;i<simplex_vertices.size();i++){
 	// SimplicialTreeNode_ptr simplex ;
 	simplex = domain_complex.find(simplex_vertices.at(i));	//get one edge
-	ListNodePtr tempLNP = domain_complex.annotations[sizes]->DeepCopyAnnotationColumn(domain_complex.find_annotation(simplex));
+	AnnotationColumnPtr tempLNP = domain_complex.annotations[sizes]->DeepCopyAnnotationColumn(domain_complex.find_annotation(simplex));
 	dead_bit = domain_complex.annotations[sizes]->sum_two_annotation_with_changed_dst(sum, tempLNP);
 	}
 	int num=0;
-	ListNodePtr trav(sum->next);
-	while (trav != sum) {
-		num += pow(2,(trav->row));
-		// cout<<"row: "<<trav->row<<" ";
-	if(trav->next==sum)
-		{
-			// cout<<"\n num: "<<num; 
-			return num;
-		}
-		trav = trav->next;
-	}
-	return -1;
+	for(size_t i=0;i<sum->rows.size();i++)
+		num += pow(2,(sum->rows[i]));
+	return (sum->empty() ? -1 : num);
 	
 }
 
-void CheckBoundaryBirthOfLoops(std::map<int, higherOrder> birthOfLoops){
-	std::map<int, higherOrder>::iterator itbl;
-	for(itbl = birthOfLoops.begin(); itbl != birthOfLoops.end(); itbl++){
-		ListNodePtr inter = AddBoundary(itbl->second);
-		if(inter->next==inter){
-			std::cout<<"Cycle in original complex shouldn't have died here."<<itbl->first<<"\n";
-			higherOrder buff = itbl->second;
-			for(int ind=0;ind<buff.size();ind++){
-				cout<<buff[ind][0]<<" "<<buff[ind][1]<<"<->";
-			}
-			exit(0);
-		}
+//annotation of the sum of the edges of a loop, given by their endpoints
+AnnotationVector loopAnnotation(const std::vector<int> &endpoints){
+	AnnotationVector anno;
+	for(size_t i=0;i+1<endpoints.size();i+=2){
+		SimplicialTreeNode_ptr simplex = domain_complex.find_edge(endpoints[i], endpoints[i+1]);
+		LoopTracker::add(anno, LoopTracker::to_vector(domain_complex.find_annotation(simplex)));
 	}
-
+	return anno;
 }
-// Takes in the current loop and set containing all loops and sees if this current one is independant, if so then this was born
-bool bornTracker(higherOrder thisLoop, std::map<int, higherOrder> birthOfLoops){
-	// Convert loops in complex to simpers data structure
-	std::vector<ListNodePtr> listofLoops;
-	std::map<int, higherOrder>::iterator itbl;
-	int countitr = 0;
-	int sizes = 1;
 
-	for(itbl = birthOfLoops.begin(); itbl != birthOfLoops.end(); itbl++){
-		ListNodePtr inter = AddBoundary(itbl->second);
-		if(inter->next==inter){
-			// simp_weight.erase(itsw); 
-			std::cout<<"Cycle in original complex shouldn't have died here."<<itbl->first<<"\n";
-			higherOrder buff = itbl->second;
-			for(int ind=0;ind<buff.size();ind++){
-				cout<<buff[ind][0]<<" "<<buff[ind][1]<<"<->";
-			}
-			exit(0);			
+// The annotations of the alive loops are kept up to date by the tracker,
+// so no loop sum is recomputed here
+void CheckBoundaryBirthOfLoops(const LoopStore &birthOfLoops, const LoopTracker &tracker){
+	int lid = tracker.dead_loop();
+	if(lid != -1){
+		std::cout<<"Cycle in original complex shouldn't have died here."<<lid<<"\n";
+		const int *buff = birthOfLoops.endpoints(lid);
+		for(int ind=0;ind<birthOfLoops.edge_count(lid);ind++){
+			cout<<buff[2*ind]<<" "<<buff[2*ind+1]<<"<->";
 		}
-
-		listofLoops.push_back(inter);
-		countitr++;
-	}
-	ListNodePtr newloop = AddBoundary(thisLoop);
-	// cout<<"This is the problem";
-						// getchar();
-
-	// Go through each loop check independance with this one to see if it is linearly independant
-	for(int itl=0;itl<listofLoops.size();itl++){
-		int proxydeadbit = domain_complex.annotations[sizes]->sum_two_annotation_with_changed_dst(listofLoops[itl], newloop);
-		if(proxydeadbit==-1)
-			return false;
-			// {						cout<<"no it aint";
-						// getchar();return false;}
+		exit(0);
 	}
-							// cout<<"no it aint";
-						// getchar();
-	return true;
 
 }
+// Takes in the current loop and the tracker of all alive loops and sees if this current one is independant, if so then this was born
+bool bornTracker(const std::vector<int> &thisLoop, const LoopStore &birthOfLoops, const LoopTracker &tracker){
+	CheckBoundaryBirthOfLoops(birthOfLoops, tracker);
+	// independant of the span of the alive loops, not just different from each of them
+	return tracker.is_independent(loopAnnotation(thisLoop));
+}
 
 
 int independantCycleCalculate(std::multimap<float, higherOrder> &simp_weight){
 
-	std::vector<ListNodePtr> listofLoops;
-	std::vector<ListNodePtr> aliveLoops;
+	std::vector<AnnotationColumnPtr> listofLoops;
+	std::vector<AnnotationColumnPtr> aliveLoops;
 	std::vector<int> aliveLoopsIndex;
 	std::vector<int> deadLoopsIndex;
 	bool nullflag = true;
@@ -353,8 +307,8 @@ int independantCycleCalculate(std::multimap<float, higherOrder> &simp_weight){
 	std::multimap<float, higherOrder>::iterator itsw;
 
 	for(itsw = simp_weight.begin(); itsw != simp_weight.end(); itsw++){
-		ListNodePtr inter = AddBoundary(itsw->second);
-		if(inter->next==inter){
+		AnnotationColumnPtr inter = AddBoundary(itsw->second);
+		if(inter->empty()){
 			std::cout<<"Cycle dead poor soul.\n";
 			return countitr;
 		}
@@ -410,16 +364,16 @@ int independantCycleCalculate2(std::map<float,int> weights, std::vector<std::vec
 	// 	cout<<"\nFirst: "<<itr->first<<" ,"<<itr->second<<"\n";
 
 
-	std::vector<ListNodePtr> listofLoops;
-	std::vector<ListNodePtr> aliveLoops;
+	std::vector<AnnotationColumnPtr> listofLoops;
+	std::vector<AnnotationColumnPtr> aliveLoops;
 	std::vector<int> aliveLoopsIndex;
 	std::vector<int> deadLoopsIndex;
 	bool nullflag = true;
 	int countitr = 0;
 	// cout<<"INDEP: higher_simp size:"<<higher_simplex.size()<<"weights:"<<weights.size()<<"\n";
 	for(itr = weights.begin(); itr != weights.end(); ++itr){
-		ListNodePtr inter = AddBoundary(higher_simplex[itr->second]);
-		if(inter->next!=inter)
+		AnnotationColumnPtr inter = AddBoundary(higher_simplex[itr->second]);
+		if(!inter->empty())
 			{std::cout<<"Cycle dead poor soul.\n"; return itr->second;}
 		listofLoops.push_back(inter);
 		countitr++;
@@ -429,7 +383,7 @@ int independantCycleCalculate2(std::map<float,int> weights, std::vector<std::vec
 	// 	std::cout<<"Cycle dead poor soul.\n";
 	// 	return itr;
 	// }
-	std::vector<ListNodePtr>::iterator itl;
+	std::vector<AnnotationColumnPtr>::iterator itl;
 	int dead_bit;
 	int sizes = 2;
 	for(int itl=0;itl<listofLoops.size();itl++){	// go through all loops in the basis
@@ -473,7 +427,7 @@ bool CheckBoundary (std::vector<std::vector<int>> simplex_vertices){
 		// simplex.clear();
 	}
 
-	ListNodePtr sum = domain_complex.annotations[sizes.at(0) ]->DeepCopyAnnotationColumn(domain_complex.find_annotation(boundaries.front()));
+	AnnotationColumnPtr sum = domain_complex.annotations[sizes.at(0) ]->DeepCopyAnnotationColumn(domain_complex.find_annotation(boundaries.front()));
 	int dead_bit = -1;
 	for (int i = 1; i < boundaries.size(); ++i){
 		if (boundaries[i] == NULL){
@@ -483,7 +437,7 @@ bool CheckBoundary (std::vector<std::vector<int>> simplex_vertices){
 			cerr << " is missing.\n";
 			exit(0);
 		}
-		ListNodePtr tempLNP = domain_complex.find_annotation(boundaries[i]);
+		AnnotationColumnPtr tempLNP = domain_complex.find_annotation(boundaries[i]);
 		dead_bit = domain_complex.annotations[sizes.at(i) ]->sum_two_annotation_with_changed_dst(sum, tempLNP);
 	}
 	if(dead_bit== -1)
@@ -13,6 +13,7 @@
 #include <cstring>
 #include <boost/unordered_set.hpp>
 #include <boost/unordered_map.hpp>
+#include <boost/function.hpp>
 #include <queue>
 #include <ctime>
 
@@ -111,16 +112,19 @@ class SimplicialTree
 public:
 	/*constructor */
 	// default constructor
-	SimplicialTree() : dim(-1), EuclideanDataPtr(NULL), accumulativeSimplexSize(0), bGenerator(false)
+	SimplicialTree() : dim(-1), EuclideanDataPtr(NULL), accumulativeSimplexSize(0), bGenerator(false),
+		bCollapsed(false), node_pool(boost::make_shared<SimplicialTreeNodePool>()), bSimplexIndex(false)
 	{
 		vecTS.resize(max_dimension + 5);
 		//counts.resize(100);
 	}
 	//
 	void UpdateAnnotationArray(const int simplex_dim);
-	ListNodePtr find_annotation(SimplicialTreeNode_ptr p);
-	SimplicialTreeNode_ptr InsertSimplexWithAnnotation(std::vector<int> &simplex_vertices, ListNodePtr &simplex_ann);
+	AnnotationColumnPtr find_annotation(SimplicialTreeNode_ptr p);
+	SimplicialTreeNode_ptr InsertSimplexWithAnnotation(std::vector<int> &simplex_vertices, AnnotationColumnPtr &simplex_ann);
 	SimplicialTreeNode_ptr ElementaryInsersion(std::vector<int> &simplex_vertices);
+	// inserts simplices sharing one filtration step, lower dimensions first
+	void InsertBatch(std::vector<std::vector<int> > &simplices);
 	// SimplicialTreeNode_ptr ElementaryInsersionPostShortLoop(std::vector<int> &simplex_vertices);
 	std::vector<int> AddTwoCycles(std::vector<int>, std::vector<int>);
 	/*deconstructor */
@@ -134,6 +138,9 @@ public:
 	// 
 	void retrieve_vertex_indices(const SimplicialTreeNode_ptr &simplex, vector<int> &simplex_vertices);
 	SimplicialTreeNode_ptr find(vector<int> &simplex_vertices);
+	SimplicialTreeNode_ptr find_edge(const int a, const int b);
+	// index the edges and triangles by their vertices from now on
+	void EnableSimplexIndex();
 	void insert_into_circular_list(const int simplex_dim, const SimplicialTreeNode_ptr & simplex);
 	SimplicialTreeNode_ptr insert_into_simplicial_tree(std::vector<int> &simplex_vertices);
 	// bool CheckBoundary (std::vector<int> simplex_vertices);
@@ -167,7 +174,7 @@ public:
 	void ElementaryCollapse(int remove_label,  int preserve_label);
 	/* ------------- simplicial complex I/O ---------------- */
 	string annotation_to_string(SimplicialTreeNode_ptr sigma);
-	ListNodePtr string_to_annotation(string &line);
+	AnnotationColumnPtr string_to_annotation(string &line);
 	void ReadComplex(const char* pFileName);
 	void ReadComplexWithAnnotation(const char* pFileName);
 	void ReadSimplicialMap(const char* pFileName, vector<pair<int, int> > &vertex_map);
@@ -211,14 +218,102 @@ public:
 	//generators for dim 1 <timeStamp, generating cycle vertices>
 	std::unordered_map<int, std::vector<int>> gen1;
 
-	std::unordered_map<int, int> reindex;
+	//called with (dim, u, sum) after every annotation in dimension dim
+	//with nonzero u-th bit has been added by sum
+	boost::function<void (const int, const int, const AnnotationColumnPtr &)> cocycle_killed;
+
+	//vertex relabelling after collapses: reindex[v] is the parent of v in a
+	//union-find forest over the dense vertex ids; no entry is a root.
+	//bCollapsed stays false until the first collapse, so that insertions
+	//skip the remapping while every vertex is its own root
+	std::vector<int> reindex;
+	bool bCollapsed;
+
+	//owns every node of the tree; shared by copies of the tree
+	boost::shared_ptr<SimplicialTreeNodePool> node_pool;
+	SimplicialTreeNode_ptr make_node(const int v_index, const int idx_filtration) {
+		node_pool->emplace_back(v_index, idx_filtration);
+		return SimplicialTreeNode_ptr(&node_pool->back());
+	}
+
+	//optional index of the edges (dim 1) and triangles (dim 2) keyed by
+	//their packed sorted vertices, which finds them with a single probe
+	//instead of a walk down the tree; kept up to date once enabled
+	bool bSimplexIndex;
+	std::unordered_map<unsigned long long, SimplicialTreeNode_ptr> simplex_index[2];
+	// bits per vertex in the key of a triangle
+	static const int TRIANGLE_KEY_BITS = 21;
+	static bool simplex_key(const int *simplex_vertices, const int n, unsigned long long &key) {
+		if (n == 2) {
+			key = ((unsigned long long)(unsigned)simplex_vertices[0] << 32) | (unsigned)simplex_vertices[1];
+			return true;
+		}
+		if (n == 3 && simplex_vertices[2] < (1 << TRIANGLE_KEY_BITS)) {
+			key = ((unsigned long long)simplex_vertices[0] << 2 * TRIANGLE_KEY_BITS)
+				| ((unsigned long long)simplex_vertices[1] << TRIANGLE_KEY_BITS) | (unsigned long long)simplex_vertices[2];
+			return true;
+		}
+		return false;
+	}
+	// looks up the edge or triangle with the sorted vertices; false if
+	// such a simplex would not be indexed
+	bool find_indexed(const int *simplex_vertices, const int n, SimplicialTreeNode_ptr &simplex) {
+		unsigned long long key;
+		if (!simplex_key(simplex_vertices, n, key))
+			return false;
+		std::unordered_map<unsigned long long, SimplicialTreeNode_ptr>::iterator mIter = simplex_index[n - 2].find(key);
+		simplex = (mIter == simplex_index[n - 2].end() ? SimplicialTreeNode_ptr() : mIter->second);
+		return true;
+	}
+	// adds or removes the simplex with the given vertices
+	void update_simplex_index(const int *simplex_vertices, const int n, const SimplicialTreeNode_ptr &simplex, const bool bInsert) {
+		unsigned long long key;
+		if (!simplex_key(simplex_vertices, n, key))
+			return;
+		if (bInsert)
+			simplex_index[n - 2][key] = simplex;
+		else {
+			std::unordered_map<unsigned long long, SimplicialTreeNode_ptr>::iterator mIter = simplex_index[n - 2].find(key);
+			if (mIter != simplex_index[n - 2].end() && mIter->second == simplex)
+				simplex_index[n - 2].erase(mIter);
+		}
+	}
+	// adds or removes the edges and triangles in the subtree of sigma,
+	// which must be called while sigma is attached to its parent
+	void update_simplex_index(const SimplicialTreeNode_ptr &sigma, const bool bInsert) {
+		if (!bSimplexIndex)
+			return;
+		vector<int> simplex_vertices;
+		retrieve_vertex_indices(sigma, simplex_vertices);
+		update_simplex_index_in_subtree(sigma, simplex_vertices, bInsert);
+	}
+	void update_simplex_index_in_subtree(const SimplicialTreeNode_ptr &sigma, vector<int> &simplex_vertices, const bool bInsert) {
+		if (simplex_vertices.size() > 3)
+			return;
+		if (simplex_vertices.size() > 1)
+			update_simplex_index(&simplex_vertices[0], (int)simplex_vertices.size(), sigma, bInsert);
+		for (SimplicialTreeChildren::iterator mIter = sigma->children.begin(); mIter != sigma->children.end(); ++mIter) {
+			simplex_vertices.push_back(mIter->first);
+			update_simplex_index_in_subtree(mIter->second, simplex_vertices, bInsert);
+			simplex_vertices.pop_back();
+		}
+	}
 
 	//std::vector<long long> counts;
 
+	void add_reindex_vertex(const int a) {
+		while ((int)reindex.size() <= a)
+			reindex.push_back((int)reindex.size());
+	}
 	int findRoot(int a) {
-		int parent = reindex[a];
-		if (parent == a) return a;
-		else return reindex[a] = findRoot(parent);
+		if (a >= (int)reindex.size())
+			return a;
+		while (reindex[a] != a) {
+			// path halving
+			reindex[a] = reindex[reindex[a]];
+			a = reindex[a];
+		}
+		return a;
 	}
 
 	//clear function
@@ -227,6 +322,8 @@ public:
 		this->dim = 0;
 		this->simplex_sizes.clear();
 		this->labels_dict_in_each_dim.clear();
+		this->simplex_index[0].clear();
+		this->simplex_index[1].clear();
 		//ufd
 		this->annotations.clear();
 		this->vecTS.resize(max_dimension + 3);
@@ -234,7 +331,7 @@ public:
 	void clearMemory();		//clear memory of annotation matrices, simplicial trees and udf trees
 
 	bool check_parent_children(SimplicialTreeNode_ptr sigma) {
-		for (std::unordered_map<int, SimplicialTreeNode_ptr>::iterator mIter = sigma->children.begin();
+		for (SimplicialTreeChildren::iterator mIter = sigma->children.begin();
 			mIter != sigma->children.end(); ++mIter) {
 			if (mIter->first != mIter->second->label) {
 				cout << "label is not consistent " << endl;
@@ -272,7 +369,7 @@ public:
 	}
 	bool check_ufd_anno() {
 		for (int i = 0; i < annotations.size(); ++i) {
-			std::unordered_map<ListNodePtr, TreeRootNodePtr, hash_ListNodePtr, equal_ListNodePtr>::iterator  mIter = annotations[i]->ann_mat.begin();
+			std::unordered_map<AnnotationColumnPtr, TreeRootNodePtr, hash_AnnotationColumnPtr, equal_AnnotationColumnPtr>::iterator  mIter = annotations[i]->ann_mat.begin();
 			for (; mIter != annotations[i]->ann_mat.end(); ++mIter) {
 				if (mIter->second->attribute != mIter->first) {
 					cout << "ufd and anno is not consistent" << endl;
@@ -376,11 +473,11 @@ private:
 		sigma->prev_circular_ptr.reset();
 	}
 	//
-	bool is_zero_annotation(ListNodePtr &ptr) {
+	bool is_zero_annotation(AnnotationColumnPtr &ptr) {
 		if (!ptr) {
 			return false; // empty 
 		}
-		return (ptr->next == ptr);
+		return ptr->empty();
 	}
 };
 
@@ -426,7 +523,7 @@ inline void SimplicialTree<T>::Report()
 	return;
 }
 template<typename T>
-ListNodePtr SimplicialTree<T>::find_annotation(SimplicialTreeNode_ptr p){
+AnnotationColumnPtr SimplicialTree<T>::find_annotation(SimplicialTreeNode_ptr p){
 	if (p->tree_node) {
 		TreeRootNodePtr root = ufd.Find(p->tree_node);
 		return root->attribute;
@@ -440,22 +537,20 @@ ListNodePtr SimplicialTree<T>::find_annotation(SimplicialTreeNode_ptr p){
 		else
 			return NULL;
 	}
-	return ListNodePtr();
+	return AnnotationColumnPtr();
 }
 template<typename T>
-ListNodePtr SimplicialTree<T>::string_to_annotation(string &line) {
+AnnotationColumnPtr SimplicialTree<T>::string_to_annotation(string &line) {
 	int start = 0;
 	while (start < line.size() && line[start] != '[') {
 		++start;
 	}
 	if (start == line.size()) {
 		// invalid annoation
-		return ListNodePtr();
+		return AnnotationColumnPtr();
 	}
 	int nonzero_bits = 0;
-	// make dummy head
-	ListNodePtr dummy_head = boost::make_shared<ListNode>();
-	ListNodePtr trav = dummy_head;
+	AnnotationColumnPtr col = boost::make_shared<AnnotationColumn>();
 	//
 	stringstream sstr(stringstream::in);
 	//
@@ -471,32 +566,28 @@ ListNodePtr SimplicialTree<T>::string_to_annotation(string &line) {
 				//cout << sstr.str() << endl;
 				sstr >> row >> val;
 				//
-				trav->next = boost::make_shared<ListNode>(row, val);
-				trav = trav->next;
+				col->push_back(row);
 				//
 				sstr.str("");
 				sstr.clear();
 			}
 		}
 	}
-	trav->next = dummy_head;
 	//
-	return dummy_head;
+	return col;
 }
 template<typename T>
 string SimplicialTree<T>::annotation_to_string(SimplicialTreeNode_ptr sigma) {
 	std::stringstream sstr(std::stringstream::in | std::stringstream::out);
-	ListNodePtr ann = find_annotation(sigma);
+	AnnotationColumnPtr ann = find_annotation(sigma);
 	if (!ann) {
 		/*cout << "annotation is not valid " << endl;
 		exit(0);*/
 		return "";
 	}
-	ListNodePtr trav(ann->next);
 	sstr << "[";
-	while (trav != ann) {
-		sstr << "<" << trav->row << " " << 1 << ">" << (trav->next == ann ? "" : " ");
-		trav = trav->next;
+	for (size_t i = 0; i < ann->rows.size(); ++i) {
+		sstr << "<" << ann->rows[i] << " " << 1 << ">" << (i + 1 == ann->rows.size() ? "" : " ");
 	}
 	sstr << "]";
 	return sstr.str();
@@ -521,13 +612,17 @@ SimplicialTreeNode_ptr SimplicialTree<T>::find(vector<int> &simplex_vertices){
 		// or the complex is empty 
 		return SimplicialTreeNode_ptr();
 	}
+	SimplicialTreeNode_ptr simplex;
+	if (bSimplexIndex && (simplex_vertices.size() == 2 || simplex_vertices.size() == 3)
+		&& find_indexed(&simplex_vertices[0], (int)simplex_vertices.size(), simplex))
+		return simplex;
 	int label = simplex_vertices.front();
 	LabelsDictionaryPtr vertices = labels_dict_in_each_dim.front();
 	SimplicialTreeNode_ptr pIter = (vertices->find(label) == vertices->end() ? SimplicialTreeNode_ptr() : (*vertices)[label]);
 	if (pIter) {
 		for (int i = 1; i < simplex_vertices.size(); ++i) {
 			label = simplex_vertices[i];
-			std::unordered_map<int, SimplicialTreeNode_ptr>::iterator pNext;
+			SimplicialTreeChildren::iterator pNext;
 			if (pIter->children.empty())
 				return SimplicialTreeNode_ptr();
 			else
@@ -542,6 +637,28 @@ SimplicialTreeNode_ptr SimplicialTree<T>::find(vector<int> &simplex_vertices){
 	return pIter;
 }
 template<typename T>
+SimplicialTreeNode_ptr SimplicialTree<T>::find_edge(const int a, const int b) {
+	int edge[2] = { std::min(a, b), std::max(a, b) };
+	SimplicialTreeNode_ptr simplex;
+	if (bSimplexIndex && find_indexed(edge, 2, simplex))
+		return simplex;
+	vector<int> simplex_vertices(edge, edge + 2);
+	return find(simplex_vertices);
+}
+template<typename T>
+void SimplicialTree<T>::EnableSimplexIndex() {
+	bSimplexIndex = true;
+	simplex_index[0].clear();
+	simplex_index[1].clear();
+	if (labels_dict_in_each_dim.empty())
+		return;
+	unordered_map<int, SimplicialTreeNode_ptr> & vertices = (*labels_dict_in_each_dim.front());
+	for (unordered_map<int, SimplicialTreeNode_ptr>::iterator mIter = vertices.begin(); mIter != vertices.end(); ++mIter) {
+		update_simplex_index(mIter->second, true);
+	}
+	return;
+}
+template<typename T>
 SimplicialTreeNode_ptr SimplicialTree<T>::insert_into_simplicial_tree(std::vector<int> &simplex_vertices) {
 	// preq:	1) simplex_vertices is sorted
 	//			2) all boundaries are inserted already
@@ -564,7 +681,7 @@ SimplicialTreeNode_ptr SimplicialTree<T>::insert_into_simplicial_tree(std::vecto
 		int ver_num = simplex_vertices[0];
 		// it is a new vertex
 		//SimplicialTreeNode_ptr simplex(boost::make_shared<SimplicialTreeNode>(ver_num, ver_num));
-		SimplicialTreeNode_ptr simplex(boost::make_shared<SimplicialTreeNode>(ver_num, ++time_in_each_filtration_step));
+		SimplicialTreeNode_ptr simplex(make_node(ver_num, ++time_in_each_filtration_step));
 		vertices[ver_num] = simplex;
 		//
 		return vertices[ver_num];
@@ -586,12 +703,14 @@ SimplicialTreeNode_ptr SimplicialTree<T>::insert_into_simplicial_tree(std::vecto
 	}
 	if (pIter->children.find(simplex_vertices.back()) == pIter->children.end()) {
 		// this simplex is not existed
-		SimplicialTreeNode_ptr simplex(boost::make_shared<SimplicialTreeNode>(simplex_vertices.back(), ++time_in_each_filtration_step));
+		SimplicialTreeNode_ptr simplex(make_node(simplex_vertices.back(), ++time_in_each_filtration_step));
 		pIter->children[simplex_vertices.back()] = simplex;
 		// 
 		simplex->parent = pIter;
 		//
 		insert_into_circular_list(simplex_dim, simplex);
+		if (bSimplexIndex)
+			update_simplex_index(&simplex_vertices[0], simplex_dim + 1, simplex, true);
 		//
 	}
 	//
@@ -610,7 +729,7 @@ void SimplicialTree<T>::UpdateAnnotationArray(const int simplex_dim) {
 }
 
 template<typename T>
-SimplicialTreeNode_ptr SimplicialTree<T>::InsertSimplexWithAnnotation(std::vector<int> &simplex_vertices, ListNodePtr &simplex_ann) {
+SimplicialTreeNode_ptr SimplicialTree<T>::InsertSimplexWithAnnotation(std::vector<int> &simplex_vertices, AnnotationColumnPtr &simplex_ann) {
 	SimplicialTreeNode_ptr simplex = find(simplex_vertices);
 	if (!simplex) {
 		// new simplex
@@ -704,11 +823,13 @@ SimplicialTreeNode_ptr SimplicialTree<T>::ElementaryInsersion(std::vector<int> &
 		b = simplex_vertices[1];
 	}
 	//reindex simplex
-	if (simplex_vertices.size() == 1 && reindex.find(simplex_vertices[0]) == reindex.end())
-		reindex[simplex_vertices[0]] = simplex_vertices[0];
+	if (simplex_vertices.size() == 1 && simplex_vertices[0] >= (int)reindex.size())
+		add_reindex_vertex(simplex_vertices[0]);
 	else {
-		for (int i = 0; i < simplex_vertices.size(); i++) {
-			simplex_vertices[i] = findRoot(simplex_vertices[i]);
+		if (bCollapsed) {
+			for (size_t i = 0; i < simplex_vertices.size(); i++) {
+				simplex_vertices[i] = findRoot(simplex_vertices[i]);
+			}
 		}
 		std::sort(simplex_vertices.begin(), simplex_vertices.end());
 	}
@@ -733,13 +854,13 @@ SimplicialTreeNode_ptr SimplicialTree<T>::ElementaryInsersion(std::vector<int> &
 
 			// put it into the union find data struture;
 			TreeRootNodePtr root = ufd.MakeSet(simplex); // connect simplex with tree_node
-			ListNodePtr newCycleAnno;
+			AnnotationColumnPtr newCycleAnno;
 			newCycleAnno = annotations[0]->create_cocycle(root, ufd); // connect tree_root_node with annotation
 			//update persistences in dim simplex_dim
 			int newTS = annotations[simplex_dim]->lowest_one(newCycleAnno);
 			if (persistences.size() < simplex_dim + 1)
 				persistences.resize(simplex_dim + 1);
-			persistences[simplex_dim].insert(std::make_pair(newTS, std::make_pair(filtration_step, -1)));
+			persistences[simplex_dim].insert(newTS, filtration_step);
 			//   
 			//check_status();
 		}
@@ -751,7 +872,12 @@ SimplicialTreeNode_ptr SimplicialTree<T>::ElementaryInsersion(std::vector<int> &
 			// 3) check the annotation sum of these boundary simplices
 			//find_annotation returns listnode pointer
 			// cout<<"Before deep copy\n";
-			ListNodePtr sum = annotations[simplex_dim - 1]->DeepCopyAnnotationColumn(find_annotation(boundaries.front()));
+			// without nonzero cocycles in simplex_dim - 1 every face has the
+			// zero annotation; the simplex creates a cocycle and the sum is skipped
+			const bool bZeroBoundary = (annotations[simplex_dim - 1]->genus() == 0);
+			AnnotationColumnPtr sum;
+			if (!bZeroBoundary)
+				sum = annotations[simplex_dim - 1]->DeepCopyAnnotationColumn(find_annotation(boundaries.front()));
 			int dead_bit = -1;
 			for (int i = 1; i < boundaries.size(); ++i){
 				if (boundaries[i] == NULL)
@@ -764,7 +890,9 @@ SimplicialTreeNode_ptr SimplicialTree<T>::ElementaryInsersion(std::vector<int> &
 					cerr << " is missing.\n";
 					exit(0);
 				}
-				ListNodePtr tempLNP = find_annotation(boundaries[i]);
+				if (bZeroBoundary)
+					continue;
+				AnnotationColumnPtr tempLNP = find_annotation(boundaries[i]);
 				dead_bit = annotations[simplex_dim - 1]->sum_two_annotation_with_changed_dst(sum, tempLNP);
 			}
 
@@ -775,13 +903,13 @@ SimplicialTreeNode_ptr SimplicialTree<T>::ElementaryInsersion(std::vector<int> &
 				if (simplex_dim <= max_dimension)
 				{
 					TreeRootNodePtr root = ufd.MakeSet(simplex); // connect simplex with tree_node
-					ListNodePtr newCycleAnno;
+					AnnotationColumnPtr newCycleAnno;
 					newCycleAnno = annotations[simplex_dim]->create_cocycle(root, ufd, annotations[simplex_dim]->empty()); // connect tree_root_node with annotation
 					//update persistences in dim simplex_dim
 					int newTS = annotations[simplex_dim]->lowest_one(newCycleAnno);
 					if (persistences.size() < simplex_dim + 1)
 						persistences.resize(simplex_dim + 1);
-					persistences[simplex_dim].insert(std::make_pair(newTS, std::make_pair(filtration_step, -1)));
+					persistences[simplex_dim].insert(newTS, filtration_step);
 					//find generator for this persistence homology class
 					if (bGenerator && simplex_dim == 1 )
 						this->gen1[newTS] = spanTree.BFS(a, b);
@@ -793,13 +921,15 @@ SimplicialTreeNode_ptr SimplicialTree<T>::ElementaryInsersion(std::vector<int> &
 				//		kill the cocycle represented by the last nonzero bit  
 
 				annotations[simplex_dim - 1]->kill_cocycle_last_nonzero_bit(dead_bit, sum, ufd);
+				if (cocycle_killed)
+					cocycle_killed(simplex_dim - 1, dead_bit, sum);
 				//update persistences in dim simplex_dim - 1
-				std::unordered_map<int, pair<int, int>>::iterator itPer = persistences[simplex_dim - 1].find(dead_bit);
+				pair<int, int> *itPer = persistences[simplex_dim - 1].find(dead_bit);
 
-				(itPer->second).second = filtration_step;
-				float diff = vecFiltrationScale[filtration_step] - vecFiltrationScale[(itPer->second).first];
+				itPer->second = filtration_step;
+				float diff = vecFiltrationScale[filtration_step] - vecFiltrationScale[itPer->first];
 				if (diff <= fThreshold && diff >= 0)
-					persistences[simplex_dim - 1].erase(itPer);
+					persistences[simplex_dim - 1].erase(dead_bit);
 				if (bGenerator) {
 					//add an edge in spanning tree
 					if (simplex_dim == 1)
@@ -809,18 +939,31 @@ SimplicialTreeNode_ptr SimplicialTree<T>::ElementaryInsersion(std::vector<int> &
 				if (simplex_dim <= max_dimension)
 				{
 					TreeRootNodePtr root = ufd.MakeSet(simplex);
-					ListNodePtr zero_ann = annotations[simplex_dim]->make_zero_annotation();
+					AnnotationColumnPtr zero_ann = annotations[simplex_dim]->make_zero_annotation();
 					annotations[simplex_dim]->Insert(zero_ann, root, ufd);
 				}
 			}
 			//check_status();
-			//break the cycle of "sum" annotation for deletion
-			sum->next.reset();
 		}
 	}
 	return simplex;
 }
 
+// simplices of the same filtration step may come in any order as long
+// as the faces are in the complex or in the batch; inserting them by
+// increasing dimension makes every face present before its cofaces
+template<typename T>
+void SimplicialTree<T>::InsertBatch(std::vector<std::vector<int> > &simplices) {
+	std::vector<std::pair<int, int> > order(simplices.size());
+	for (size_t i = 0; i < simplices.size(); ++i)
+		order[i] = std::make_pair((int)simplices[i].size(), (int)i);
+	std::sort(order.begin(), order.end());
+	for (size_t i = 0; i < order.size(); ++i) {
+		ElementaryInsersion(simplices[order[i].second]);
+	}
+	return;
+}
+
 template <class T>
 bool SimplicialTree<T>::Boundary(const SimplicialTreeNode_ptr& sigma, std::vector<SimplicialTreeNode_ptr> &bdries)
 {
@@ -833,6 +976,33 @@ bool SimplicialTree<T>::Boundary(const SimplicialTreeNode_ptr& sigma, std::vecto
 	// vertex simplex doesn't have boundary
 	// the half vertex set
 	std::vector<int> tail_ver_index_set;
+	if (bSimplexIndex && pIter->parent && SimplexDim(sigma) <= 3)
+	{// the faces are vertices or indexed; drop the vertices from the last one
+		int simplex_vertices[4];
+		int n = 0;
+		for (; pIter; pIter = pIter->parent)
+			simplex_vertices[n++] = pIter->label;
+		std::reverse(simplex_vertices, simplex_vertices + n);
+		for (int k = n - 1; k >= 0; --k) {
+			int face[3];
+			for (int i = 0, j = 0; i < n; ++i) {
+				if (i != k)
+					face[j++] = simplex_vertices[i];
+			}
+			if (n == 2) {
+				bdries.push_back(vertices[face[0]]);
+				continue;
+			}
+			if (!find_indexed(face, n - 1, pBdryFace) || !pBdryFace)
+				break;
+			bdries.push_back(pBdryFace);
+		}
+		if (bdries.size() == (size_t)n)
+			return true;
+		// some face is not indexed; fall back to the walk
+		bdries.clear();
+		pIter = sigma;
+	}
 	if (pIter->parent)
 	{// simplex of dim > 0
 		do
@@ -923,7 +1093,7 @@ void SimplicialTree<T>::retrieve_simplices_from_subtrees(const SimplicialTreeNod
 			SimplicialTreeNode_ptr curr = S.top();
 			bool to_be_visited = true;
 			if (!curr->children.empty()) {
-				for (std::unordered_map<int, SimplicialTreeNode_ptr>::iterator mIter = curr->children.begin();
+				for (SimplicialTreeChildren::iterator mIter = curr->children.begin();
 					mIter != curr->children.end(); ++mIter) {
 					if (visited.find(mIter->second) == visited.end()) {
 						to_be_visited = false;
@@ -945,7 +1115,7 @@ void SimplicialTree<T>::retrieve_simplices_from_subtrees(const SimplicialTreeNod
 			SimplicialTreeNode_ptr curr = Q.front();
 			Q.pop();
 			coBdries.push_back(curr);
-			for (std::unordered_map<int, SimplicialTreeNode_ptr>::iterator mIter = curr->children.begin();
+			for (SimplicialTreeChildren::iterator mIter = curr->children.begin();
 				mIter != curr->children.end(); ++mIter) {
 				Q.push(mIter->second);
 			}
@@ -1029,7 +1199,7 @@ void SimplicialTree<T>::CoDimensionOneFaces(const SimplicialTreeNode_ptr& sigma,
 	retrieve_vertex_indices(sigma, simplex_vertices);
 	int simplex_dim = (int)simplex_vertices.size() - 1;
 	//
-	for (std::unordered_map<int, SimplicialTreeNode_ptr>::iterator mIter = sigma->children.begin();
+	for (SimplicialTreeChildren::iterator mIter = sigma->children.begin();
 		mIter != sigma->children.end(); ++mIter) {
 		codim_one_faces.push_back(mIter->second);
 	}
@@ -1090,7 +1260,7 @@ bool SimplicialTree<T>::CoBoundary(const SimplicialTreeNode_ptr& sigma, std::vec
 	retrieve_vertex_indices(sigma, simplex_vertices);
 	int simplex_dim = (int)simplex_vertices.size() - 1;
 	//
-	for (std::unordered_map<int, SimplicialTreeNode_ptr>::iterator mIter = sigma->children.begin();
+	for (SimplicialTreeChildren::iterator mIter = sigma->children.begin();
 		mIter != sigma->children.end(); ++mIter) {
 		retrieve_simplices_from_subtrees(mIter->second, coBdries, dfs_visit);
 	}
@@ -1394,7 +1564,7 @@ void SimplicialTree<T>::AnnotationTransfer(SimplicialTreeNode_ptr &edge, const i
 		int simplex_dim = SimplexDim(edge_cofaces[i]);
 		if (simplex_dim <= max_dimension)
 		{
-			ListNodePtr vanishing_simplex_annotation = find_annotation(edge_cofaces[i]);
+			AnnotationColumnPtr vanishing_simplex_annotation = find_annotation(edge_cofaces[i]);
 			if (!is_zero_annotation(vanishing_simplex_annotation)) {
 				//check_status();
 				vanishing_simplex_annotation = annotations[simplex_dim]->DeepCopyAnnotationColumn(vanishing_simplex_annotation);
@@ -1417,7 +1587,7 @@ void SimplicialTree<T>::AnnotationTransfer(SimplicialTreeNode_ptr &edge, const i
 				for (int j = 0; j < codim_one_faces.size(); ++j) {
 					//
 					//cout << j << "\t"; check_status(); 
-					ListNodePtr codim_one_face_annotation = annotations[simplex_dim]->DeepCopyAnnotationColumn(find_annotation(codim_one_faces[j]));
+					AnnotationColumnPtr codim_one_face_annotation = annotations[simplex_dim]->DeepCopyAnnotationColumn(find_annotation(codim_one_faces[j]));
 					// delete the tree and the annotation it is pointed to
 					if (ufd.Is_singleton(codim_one_faces[j]->tree_node)) {
 						// after deletion also delete the annotation
@@ -1466,7 +1636,9 @@ void SimplicialTree<T>::ElementaryCollapse(int remove_label, int preserve_label)
 	//always collpase larger index to smaller index and update reindex
 	if (remove_label < preserve_label) {
 		cout<<"Collapse3";
+		add_reindex_vertex(preserve_label);
 		reindex[preserve_label] = remove_label;
+		bCollapsed = true;
 		std::swap(remove_label, preserve_label);
 	}
 	// apply annotation transfer
@@ -1551,7 +1723,7 @@ void SimplicialTree<T>::rename_simplices_in_subtree(SimplicialTreeNode_ptr sigma
 			simplex_vertices.push_back(0); // one dimension higher simplex
 			vector<int> ordered_children;
 			ordered_children.reserve(curr->children.size());
-			for (std::unordered_map<int, SimplicialTreeNode_ptr>::iterator mIter = curr->children.begin();
+			for (SimplicialTreeChildren::iterator mIter = curr->children.begin();
 				mIter != curr->children.end(); ++mIter) {
 				ordered_children.push_back(mIter->first);
 			}
@@ -1574,11 +1746,13 @@ void SimplicialTree<T>::rename_simplices_in_subtree(SimplicialTreeNode_ptr sigma
 						// no need to generate a new node;
 						// move this node and all children to the new position
 						SimplicialTreeNode_ptr parent = flags[curr].first;
+						update_simplex_index(child, false);
 						parent->children[child->label] = child;
 						// remove it from it parent
 						child->parent->children.erase(child->label);
 						// update its new parent
 						child->parent = parent;
+						update_simplex_index(child, true);
 						//do not move write pointer
 					}
 					else {
@@ -1628,6 +1802,7 @@ void SimplicialTree<T>::remove_simplex_from_complex(SimplicialTreeNode_ptr sigma
 		exit(0);
 	}
 	int simplex_dim = SimplexDim(sigma);
+	update_simplex_index(sigma, false);
 	//sigma->tree_node.reset(); reset in ufd.Delete
 	// parent-children relation
 	sigma->parent->children.erase(sigma->label);
@@ -1656,6 +1831,7 @@ void SimplicialTree<T>::remove_simplex_from_both_complex_and_ufdForest(Simplicia
 		exit(0);
 	}
 	int simplex_dim = SimplexDim(sigma);
+	update_simplex_index(sigma, false);
 	if (simplex_dim <= max_dimension)
 	{
 		if (ufd.Is_singleton(sigma->tree_node)) {
@@ -1695,7 +1871,7 @@ template <typename T>
 void SimplicialTree<T>::SnapshotHomologicalFeatures(vector<unordered_set<int> > &hom_info) {
 	for (int i = 0; i < annotations.size(); ++i) {
 		unordered_set<int> cycles;
-		for (unordered_map<int, ListNodePtr>::iterator mIter = annotations[i]->row_ptr.begin();
+		for (unordered_map<int, AnnotationRowMembers>::iterator mIter = annotations[i]->row_ptr.begin();
 			mIter != annotations[i]->row_ptr.end(); ++mIter) {
 			cycles.insert(mIter->first);
 		}
@@ -1805,6 +1981,8 @@ void SimplicialTree<T>::clearMemory()		//clear memory of annotation matrices, si
 			}
 		}
 	}
+	//free the nodes all at once
+	node_pool = boost::make_shared<SimplicialTreeNodePool>();
 }
 
 //relabeling vertices
@@ -1830,8 +2008,8 @@ void SimplicialTree<T>::RelabelingVertices(unordered_map<int, int> &vertex_map)
 				//update children map
 				if (mIter->second->children.size() != 0)
 				{
-					std::unordered_map<int, SimplicialTreeNode_ptr> newChildren;
-					std::unordered_map<int, SimplicialTreeNode_ptr>::iterator mIterChildren = mIter->second->children.begin();
+					SimplicialTreeChildren newChildren;
+					SimplicialTreeChildren::iterator mIterChildren = mIter->second->children.begin();
 					for (; mIterChildren != mIter->second->children.end(); ++mIterChildren)
 					{
 						newChildren[vertex_map[mIterChildren->first]] = mIterChildren->second;
@@ -1849,8 +2027,8 @@ void SimplicialTree<T>::RelabelingVertices(unordered_map<int, int> &vertex_map)
 					if (trav->children.size() != 0)
 					{
 						//update children map
-						std::unordered_map<int, SimplicialTreeNode_ptr> newChildren;
-						std::unordered_map<int, SimplicialTreeNode_ptr>::iterator mIterChildren = trav->children.begin();
+						SimplicialTreeChildren newChildren;
+						SimplicialTreeChildren::iterator mIterChildren = trav->children.begin();
 						for (; mIterChildren != trav->children.end(); ++mIterChildren)
 						{
 							newChildren[vertex_map[mIterChildren->first]] = mIterChildren->second;
@@ -1870,6 +2048,8 @@ void SimplicialTree<T>::RelabelingVertices(unordered_map<int, int> &vertex_map)
 	//relabeling labels_dict_in_each_dim by copying new_labels_dict_in_each_dim back
 	//labels_dict_in_each_dim.clear();
 	labels_dict_in_each_dim = new_labels_dict_in_each_dim;
+	if (bSimplexIndex)
+		EnableSimplexIndex();
 	return;
 }
 
@@ -1891,7 +2071,7 @@ void SimplicialTree<T>::InitializeByRenamingIncomingComplex(SimplicialTree<T> &s
 			// handle vertices
 			simplex_vertices.resize(1);
 			for (; mIter != labels_dict.end(); ++mIter) {
-				ListNodePtr simplex_ann = src.annotations[i]->DeepCopyAnnotationColumn(src.find_annotation(mIter->second));
+				AnnotationColumnPtr simplex_ann = src.annotations[i]->DeepCopyAnnotationColumn(src.find_annotation(mIter->second));
 				simplex_vertices.front() = vertex_map[mIter->first];
 				//
 				InsertSimplexWithAnnotation(simplex_vertices, simplex_ann);
@@ -1911,7 +2091,7 @@ void SimplicialTree<T>::InitializeByRenamingIncomingComplex(SimplicialTree<T> &s
 					//  
 					if (i <= max_dimension)
 					{
-						ListNodePtr simplex_ann = src.annotations[i]->DeepCopyAnnotationColumn(src.find_annotation(trav));
+						AnnotationColumnPtr simplex_ann = src.annotations[i]->DeepCopyAnnotationColumn(src.find_annotation(trav));
 						InsertSimplexWithAnnotation(simplex_vertices, simplex_ann);
 					}
 					else
@@ -2090,7 +2270,7 @@ void SimplicialTree<T>::ReadComplexWithAnnotation(const char* pFileName) {
 				}
 				if (simplex_count > 0 && !simplex_vertices.empty()) {
 					--simplex_count;
-					ListNodePtr simplex_ann = string_to_annotation(line);
+					AnnotationColumnPtr simplex_ann = string_to_annotation(line);
 					InsertSimplexWithAnnotation(simplex_vertices, simplex_ann);
 					//initialize time stamp for each annotation matrix
 					int simplexDimension = simplex_vertices.size() - 1;
@@ -2170,6 +2350,9 @@ void SimplicialTree<T>::ReadComplex(const char* pFileName) {
 			iss >> simplex_count;
 			iss.clear();
 			iss.str("");
+			// the whole complex comes in one filtration step
+			vector<vector<int> > simplices;
+			simplices.reserve(simplex_count > 0 ? simplex_count : 0);
 			while (getline(sstr, line)) {
 				simplex_vertices.clear();
 				iss.str(line);
@@ -2179,14 +2362,15 @@ void SimplicialTree<T>::ReadComplex(const char* pFileName) {
 				}
 				if (simplex_count > 0 && !simplex_vertices.empty()) {
 					--simplex_count;
-					std::clock_t timer = std::clock();
-					ElementaryInsersion(simplex_vertices);
-					dInsertTime += std::clock() - timer;
+					simplices.push_back(simplex_vertices);
 				}
 				line.clear();
 				iss.clear();
 				iss.str("");
 			}
+			std::clock_t timer = std::clock();
+			InsertBatch(simplices);
+			dInsertTime += std::clock() - timer;
 		}
 	}
 	else {
@@ -2239,7 +2423,7 @@ void SimplicialTree<T>::PrintComplexWithAnnotation() {
 		unordered_map<int, int> newIndices;
 		vector<int> nonzero_bits;
 		nonzero_bits.reserve(annotations[i]->row_ptr.size());
-		for (unordered_map<int, ListNodePtr>::iterator bitIter = annotations[i]->row_ptr.begin();
+		for (unordered_map<int, AnnotationRowMembers>::iterator bitIter = annotations[i]->row_ptr.begin();
 			bitIter != annotations[i]->row_ptr.end(); ++bitIter) {
 			nonzero_bits.push_back(bitIter->first);
 		}
@@ -2312,7 +2496,7 @@ void SimplicialTree<T>::WriteComplexWithAnnotation(const char* pFileName) {
 			//unordered_map<int, int> newIndices;
 			//vector<int> nonzero_bits;
 			//nonzero_bits.reserve(annotations[i]->row_ptr.size());
-			//for (unordered_map<int, ListNodePtr>::iterator bitIter = annotations[i]->row_ptr.begin();
+			//for (unordered_map<int, AnnotationRowMembers>::iterator bitIter = annotations[i]->row_ptr.begin();
 			//	bitIter != annotations[i]->row_ptr.end(); ++bitIter) {
 			//	nonzero_bits.push_back(bitIter->first);
 			//}
@@ -7,134 +7,145 @@
 #include <stack>
 
 using namespace std;
+TreeIndex UnionFindDeletion::new_node()
+{
+	TreeIndex a;
+	if (forest->free_nodes.empty()) {
+		a = (TreeIndex)forest->nodes.size();
+		forest->nodes.push_back(TreeNode());
+		forest->elem.push_back(ElementNodePtr());
+		forest->attribute.push_back(AnnotationColumnPtr());
+	}
+	else {
+		a = forest->free_nodes.back();
+		forest->free_nodes.pop_back();
+		node(a) = TreeNode();
+	}
+	return a;
+}
+void UnionFindDeletion::free_node(TreeIndex a)
+{
+	forest->elem[a].reset();
+	forest->attribute[a].reset();
+	forest->free_nodes.push_back(a);
+	return;
+}
 TreeRootNodePtr UnionFindDeletion::MakeSet(ElementNodePtr &elem)
 {
-	//std::unordered_map<int, ElementNodePtr>::iterator findIter = elemSet.find(elem->value);
-	//
-	//if (findIter == elemSet.end())
-	//{ 
 	//Create a new tree root node
-	TreeRootNodePtr root(boost::make_shared<TreeRootNode>());
+	TreeIndex root = new_node();
 	//Set double-links between the element node and the tree node
 	link_tree_node_and_element(root, elem);
 
-	/*Initializing tree root data*/
-	//Store the tree root in the forest
-	//forest[elem->value] = root;
-	//Store the element value in the hash of elments
-	//elemSet[elem->value] = elem;
-
 	/*Initializing tree node*/
+	TreeNode &r = node(root);
 	//Set parent
-	root->parent = root;
+	r.parent = root;
 	//Set rank
-	root->rank = 0;
-	root->cListSize = 0;
+	r.rank = 0;
+	r.cListSize = 0;
 	//Set dfsList
-	root->dfsNext = root;
-	root->dfsPrev = root;
+	r.dfsNext = root;
+	r.dfsPrev = root;
 
-	//}
-	//else
-	//{
-	//	std::cout << "The element [" << elem->value << "] exists" << std::endl; 
-	//	std::cout << "MAKESET operation is NOT performed" << std::endl;
-	//}
-	//
-	//return forest[elem->value];
-	return root;
+	return handle(root);
 }
-void UnionFindDeletion::insert_into_nlist(TreeNodePtr a, TreeRootNodePtr &T)
+void UnionFindDeletion::insert_into_nlist(TreeIndex a, TreeIndex T)
 {
-	if (T->nListHead) {
-		TreeNodePtr tail = T->nListHead->nPrev;
+	if (node(T).nListHead) {
+		TreeIndex head = node(T).nListHead;
+		TreeIndex tail = node(head).nPrev;
 		// head-->a-->tail
 		// head<--a<--tail
-		T->nListHead->nPrev = a;
-		a->nPrev = tail;
-		tail->nNext = a;
-		a->nNext = T->nListHead;
+		node(head).nPrev = a;
+		node(a).nPrev = tail;
+		node(tail).nNext = a;
+		node(a).nNext = head;
 
-		T->nListHead = a;
+		node(T).nListHead = a;
 	}
 	else {
-		T->nListHead = a;
-		a->nNext = a;
-		a->nPrev = a;
+		node(T).nListHead = a;
+		node(a).nNext = a;
+		node(a).nPrev = a;
 	}
 	return;
 }
-void UnionFindDeletion::insert_into_clist_and_dfs_list(TreeNodePtr a, TreeNodePtr parent)
+void UnionFindDeletion::insert_into_clist_and_dfs_list(TreeIndex a, TreeIndex parent)
 {
 	//Add to the children list 
-	if (parent->cListHead)
+	if (node(parent).cListHead)
 	{// insert to the begining of the list
-		TreeNodePtr cListTail = parent->cListHead->cPrev;
+		TreeIndex head = node(parent).cListHead;
+		TreeIndex cListTail = node(head).cPrev;
 		// head-->a-->tail
 		// head<--a<--tail
-		parent->cListHead->cPrev = a;
-		a->cPrev = cListTail;
-		cListTail->cNext = a;
-		a->cNext = parent->cListHead;
+		node(head).cPrev = a;
+		node(a).cPrev = cListTail;
+		node(cListTail).cNext = a;
+		node(a).cNext = head;
 
-		parent->cListHead = a;
+		node(parent).cListHead = a;
 	}
 	else
 	{//The first element of cListHead
-		parent->cListHead = a;
-		a->cNext = a;
-		a->cPrev = a;
+		node(parent).cListHead = a;
+		node(a).cNext = a;
+		node(a).cPrev = a;
 	}
 	//Add to dfsList of T_keep 
-	TreeNodePtr parent_dfsNext = parent->dfsNext;
-	TreeNodePtr child_dfsTail = a->dfsPrev;
+	TreeIndex parent_dfsNext = node(parent).dfsNext;
+	TreeIndex child_dfsTail = node(a).dfsPrev;
 
 	// parent-->a----a_tail->parent_next
 	// parent<--a----a_tail<--parent_next
-	a->dfsPrev = parent;
-	parent->dfsNext = a;
+	node(a).dfsPrev = parent;
+	node(parent).dfsNext = a;
 
-	child_dfsTail->dfsNext = parent_dfsNext;
-	parent_dfsNext->dfsPrev = child_dfsTail;
+	node(child_dfsTail).dfsNext = parent_dfsNext;
+	node(parent_dfsNext).dfsPrev = child_dfsTail;
 
 	//Update counters
-	parent->cListSize++;
+	node(parent).cListSize++;
 
 	return;
 }
-void UnionFindDeletion::LinkSingleNodeToTreeRoot(TreeNodePtr a, TreeRootNodePtr &T)
+void UnionFindDeletion::LinkSingleNodeToTreeRoot(TreeIndex a, TreeIndex T)
 {
+	TreeNode &n = node(a);
 	//Link to the root of T_keep
-	a->parent = T;
+	n.parent = T;
 	//Set its rank as zero
-	a->rank = 0;
+	n.rank = 0;
 	//Set cListHead and its size
-	a->cListHead.reset();
-	a->cListSize = 0;
+	n.cListHead = 0;
+	n.cListSize = 0;
 	//prepare for insert into dfs_list
-	a->dfsNext = a;
-	a->dfsPrev = a;
+	n.dfsNext = a;
+	n.dfsPrev = a;
 	//
 	insert_into_clist_and_dfs_list(a, T);
 
 	return;
 
 }
-TreeRootNodePtr UnionFindDeletion::Union(TreeRootNodePtr & a, TreeRootNodePtr & b)
+TreeRootNodePtr UnionFindDeletion::Union(TreeRootNodePtr & a_root, TreeRootNodePtr & b_root)
 {
+	TreeIndex a = a_root.index;
+	TreeIndex b = b_root.index;
 	if (a == b) {
-		return a;
+		return a_root;
 	}
-	TreeRootNodePtr dead = a; // dead refer to the tree to be destroyed
-	TreeRootNodePtr alive = b;
+	TreeIndex dead = a; // dead refer to the tree to be destroyed
+	TreeIndex alive = b;
 	//
 	int a_size = 4;
-	if (!a->nListHead) {
-		a_size = a->cListSize + 1;
+	if (!node(a).nListHead) {
+		a_size = node(a).cListSize + 1;
 	}
 	int b_size = 4;
-	if (!b->nListHead) {
-		b_size = b->cListSize + 1;
+	if (!node(b).nListHead) {
+		b_size = node(b).cListSize + 1;
 	}
 
 	if (a_size < 4 || b_size < 4)
@@ -144,257 +155,248 @@ TreeRootNodePtr UnionFindDeletion::Union(TreeRootNodePtr & a, TreeRootNodePtr &
 			dead = b;
 			alive = a;
 		}
-		// remove it from the forest
-		//forest.erase(dead->elem->value);
 		// 		
-		TreeNodePtr trav = dead->cListHead;
+		TreeIndex trav = node(dead).cListHead;
 		while (trav) {
-			if (trav->cNext == dead->cListHead) {
-				dead->cListHead.reset();
+			if (node(trav).cNext == node(dead).cListHead) {
+				node(dead).cListHead = 0;
 			}
 			else {
-				dead->cListHead = trav->cNext;
-				trav->cNext->cPrev = trav->cPrev;
-				trav->cPrev->cNext = trav->cNext;
+				TreeIndex next = node(trav).cNext;
+				TreeIndex prev = node(trav).cPrev;
+				node(dead).cListHead = next;
+				node(next).cPrev = prev;
+				node(prev).cNext = next;
 			}
 			LinkSingleNodeToTreeRoot(trav, alive);
-			trav = dead->cListHead;
+			trav = node(dead).cListHead;
 		}
 		// 
 		LinkSingleNodeToTreeRoot(dead, alive);
 		// update the root's rank
-		alive->rank = std::max(alive->rank, 1);
+		node(alive).rank = std::max(node(alive).rank, 1);
 		//
 	}
 	else
 	{
-		if (a->rank > b->rank)
+		if (node(a).rank > node(b).rank)
 		{
 			dead = b;
 			alive = a;
 		}
-		dead->parent = alive;
+		node(dead).parent = alive;
 		// update root's rank
-		if (dead->rank == alive->rank) {
-			++alive->rank;
+		if (node(dead).rank == node(alive).rank) {
+			++node(alive).rank;
 		}
-		//forest.erase(dead->elem->value);
 		// set rank of T_keep
 		insert_into_nlist(dead, alive);
 		insert_into_clist_and_dfs_list(dead, alive);
 		// 
-		dead->nListHead.reset();
+		node(dead).nListHead = 0;
 	}
-	return alive;
+	return handle(alive);
 }
-void UnionFindDeletion::InsertIntoCList(TreeNodePtr p, TreeNodePtr ref, TreeNodePtr a, bool right)
+void UnionFindDeletion::InsertIntoCList(TreeIndex p, TreeIndex ref, TreeIndex a, bool right)
 {
 	//
-	a->parent = p;
-	if (p->cListHead)
+	node(a).parent = p;
+	if (node(p).cListHead)
 	{
 		if (right)
 		{
 			// next--ref---a--prev
-			TreeNodePtr prev = ref->cPrev;
-			prev->cNext = a;
-			a->cPrev = prev;
-			ref->cPrev = a;
-			a->cNext = ref;
-			if (ref == p->cListHead) {
-				p->cListHead = a;
+			TreeIndex prev = node(ref).cPrev;
+			node(prev).cNext = a;
+			node(a).cPrev = prev;
+			node(ref).cPrev = a;
+			node(a).cNext = ref;
+			if (ref == node(p).cListHead) {
+				node(p).cListHead = a;
 			}
 		}
 		else
 		{// insert to the left of ref
 			//next--a--ref--prev
-			TreeNodePtr next = ref->cNext;
-			next->cPrev = a;
-			a->cNext = next;
-			ref->cNext = a;
-			a->cPrev = ref;
+			TreeIndex next = node(ref).cNext;
+			node(next).cPrev = a;
+			node(a).cNext = next;
+			node(ref).cNext = a;
+			node(a).cPrev = ref;
 		}
 	}
 	else
 	{
-		p->cListHead = a;
-		a->cNext = a;
-		a->cPrev = a;
+		node(p).cListHead = a;
+		node(a).cNext = a;
+		node(a).cPrev = a;
 	}
 	// 
-	p->cListSize++;
+	node(p).cListSize++;
 	//
 
 	return;
 }
-void UnionFindDeletion::RemoveFromCList(TreeNodePtr a)
+void UnionFindDeletion::RemoveFromCList(TreeIndex a)
 {// a is not the root
-	TreeNodePtr p = a->parent;
-	a->parent.reset();
-	if (p->cListSize == 1)
+	TreeIndex p = node(a).parent;
+	node(a).parent = 0;
+	if (node(p).cListSize == 1)
 	{
-		p->cListHead.reset();
-		//
-		a->cNext.reset();
-		a->cPrev.reset();
-		// 
+		node(p).cListHead = 0;
 	}
 	else
 	{
-		TreeNodePtr prev = a->cPrev;
-		TreeNodePtr next = a->cNext;
+		TreeIndex prev = node(a).cPrev;
+		TreeIndex next = node(a).cNext;
 		//
-		prev->cNext = next;
-		next->cPrev = prev;
-		if (a == p->cListHead) {
-			p->cListHead = next;
+		node(prev).cNext = next;
+		node(next).cPrev = prev;
+		if (a == node(p).cListHead) {
+			node(p).cListHead = next;
 		}
-		//
-		a->cNext.reset();
-		a->cPrev.reset();
 	}
+	node(a).cNext = 0;
+	node(a).cPrev = 0;
 	// 
-	p->cListSize--;
+	node(p).cListSize--;
 	//
 
 	return;
 }
-void UnionFindDeletion::RemoveFromNList(TreeNodePtr a)
+void UnionFindDeletion::RemoveFromNList(TreeIndex a)
 {
-	TreeRootNodePtr root = find_root(a);//forest[a->parent->elem->value];
+	TreeIndex root = find_root(a);
+	TreeIndex head = node(root).nListHead;
 	//
-	if (root->nListHead->nNext == root->nListHead)
+	if (node(head).nNext == head)
 	{// only one element
-		root->nListHead.reset();
+		node(root).nListHead = 0;
 	}
 	else
 	{
-		TreeNodePtr head = root->nListHead;
-		TreeNodePtr prev = a->nPrev;
-		TreeNodePtr next = a->nNext;
+		TreeIndex prev = node(a).nPrev;
+		TreeIndex next = node(a).nNext;
 		//
-		prev->nNext = next;
-		next->nPrev = prev;
+		node(prev).nNext = next;
+		node(next).nPrev = prev;
 		if (a == head) {
-			root->nListHead = next;
+			node(root).nListHead = next;
 		}
 	}
 	return;
 }
-void UnionFindDeletion::InsertIntoNList(TreeRootNodePtr p, TreeNodePtr ref, TreeNodePtr a) {
-	if (p->parent == p)
+void UnionFindDeletion::InsertIntoNList(TreeIndex p, TreeIndex ref, TreeIndex a) {
+	if (node(p).parent == p)
 	{// p is also the root
-		if (a->cListSize > 0)
+		if (node(a).cListSize > 0)
 		{// insert it into the NList of the root
-			TreeNodePtr next = ref->nNext;
-			next->nPrev = a;
-			a->nNext = next;
-			ref->nNext = a;
-			a->nPrev = ref;
+			TreeIndex next = node(ref).nNext;
+			node(next).nPrev = a;
+			node(a).nNext = next;
+			node(ref).nNext = a;
+			node(a).nPrev = ref;
 		}
 	}
 	return;
 }
-void UnionFindDeletion::Relink(TreeNodePtr a)
+void UnionFindDeletion::Relink(TreeIndex a)
 {// p(p(a)) is not the root
-	TreeNodePtr p = a->parent;
-	if (a->cNext != p->cListHead)
+	TreeIndex p = node(a).parent;
+	TreeIndex pp = node(p).parent;
+	if (node(a).cNext != node(p).cListHead)
 	{// a has a left sibling
-		TreeNodePtr L = a->cNext;
+		TreeIndex L = node(a).cNext;
 		// remove a from CList of p
 		RemoveFromCList(a);
 		// add it into 
-		InsertIntoCList(p->parent, p, a, true);
-		if (p->parent->parent == p->parent && a->cListSize > 0) {
-			TreeRootNodePtr root = find_root(p->parent);//forest[p->parent->elem->value];
+		InsertIntoCList(pp, p, a, true);
+		if (node(pp).parent == pp && node(a).cListSize > 0) {
+			TreeIndex root = find_root(pp);
 			InsertIntoNList(root, p, a);
 		}
 		// remove the segment from DFSList
-		TreeNodePtr tail = L->dfsPrev;
+		TreeIndex tail = node(L).dfsPrev;
+		TreeIndex a_dfsPrev = node(a).dfsPrev;
 		// disconnect [a, tail]
-		L->dfsPrev = a->dfsPrev;
-		a->dfsPrev->dfsNext = L;
+		node(L).dfsPrev = a_dfsPrev;
+		node(a_dfsPrev).dfsNext = L;
 		// insert [a, tail] before p in DFSList
-		tail->dfsNext = p;
-		a->dfsPrev = p->dfsPrev;
-		p->dfsPrev->dfsNext = a;
-		p->dfsPrev = tail;
+		TreeIndex p_dfsPrev = node(p).dfsPrev;
+		node(tail).dfsNext = p;
+		node(a).dfsPrev = p_dfsPrev;
+		node(p_dfsPrev).dfsNext = a;
+		node(p).dfsPrev = tail;
 	}
 	else
 	{
 		// remove a from CList of p
 		RemoveFromCList(a);
 		// add it into 
-		InsertIntoCList(p->parent, p, a, false);
-		if (p->parent->parent == p->parent && a->cListSize > 0) {
-			TreeRootNodePtr root = find_root(p->parent);//forest[p->parent->elem->value];
+		InsertIntoCList(pp, p, a, false);
+		if (node(pp).parent == pp && node(a).cListSize > 0) {
+			TreeIndex root = find_root(pp);
 			InsertIntoNList(root, p, a);
 		}
 	}
 	// if p is leaf 
-	if (p->cListSize == 0)
+	if (node(p).cListSize == 0)
 	{
-		p->rank = 0;
+		node(p).rank = 0;
 		//
-		if (p->parent->parent == p->parent)
+		if (node(pp).parent == pp)
 		{// p->parent is the root
 			RemoveFromNList(p);
 			// if NList is empty, the tree is reduced
-			TreeRootNodePtr root = find_root(p->parent);//forest[p->parent->elem->value];
-			if (!root->nListHead) {
-				p->parent->rank = 1;
+			TreeIndex root = find_root(pp);
+			if (!node(root).nListHead) {
+				node(pp).rank = 1;
 			}
 		}
 
 	}
 }
-TreeRootNodePtr UnionFindDeletion::Find(TreeNodePtr a)
+TreeRootNodePtr UnionFindDeletion::Find(TreeNodePtr curr)
 {
-	while (a->parent->parent != a->parent)
+	TreeIndex a = curr.index;
+	while (node(node(a).parent).parent != node(a).parent)
 	{
-		TreeNodePtr p = a->parent;
+		TreeIndex p = node(a).parent;
 		Relink(a);
-		if (p->cListSize == 2)
+		if (node(p).cListSize == 2)
 		{
-			while (p->cListSize > 0)
+			while (node(p).cListSize > 0)
 			{
-				Relink(p->cListHead);
+				Relink(node(p).cListHead);
 			}
 		}
 		a = p;
 	}
-	TreeRootNodePtr root = find_root(a->parent);//forest[a->parent->elem->value];
-	return root;
+	return handle(find_root(node(a).parent));
 }
-void UnionFindDeletion::RemoveFromDFSList(TreeNodePtr a)
+void UnionFindDeletion::RemoveFromDFSList(TreeIndex a)
 {// a is not the root unless the tree contains only the root
-	if (a->parent == a)
-	{
-		a->dfsNext.reset();
-		a->dfsPrev.reset();
-	}
-	else
+	if (node(a).parent != a)
 	{
-		TreeNodePtr next = a->dfsNext;
-		TreeNodePtr prev = a->dfsPrev;
+		TreeIndex next = node(a).dfsNext;
+		TreeIndex prev = node(a).dfsPrev;
 		//
-		next->dfsPrev = prev;
-		prev->dfsNext = next;
-		//
-		a->dfsNext.reset();
-		a->dfsPrev.reset();
+		node(next).dfsPrev = prev;
+		node(prev).dfsNext = next;
 	}
+	node(a).dfsNext = 0;
+	node(a).dfsPrev = 0;
 	return;
 }
-void UnionFindDeletion::DeleteFromReducedTree(TreeNodePtr a)
+void UnionFindDeletion::DeleteFromReducedTree(TreeIndex a)
 {// the tree is reduced
-	TreeNodePtr to_be_deleted = a;
-	if (a->parent == a && a->cListSize > 0)
+	TreeIndex to_be_deleted = a;
+	if (node(a).parent == a && node(a).cListSize > 0)
 	{// a is the root 
-		to_be_deleted = a->dfsPrev;
+		to_be_deleted = node(a).dfsPrev;
 		//switch conents
-		ElementNodePtr keepElem = to_be_deleted->elem;
-		ElementNodePtr rootElem = a->elem;
+		ElementNodePtr keepElem = forest->elem[to_be_deleted];
+		ElementNodePtr rootElem = forest->elem[a];
 		//
 		unlink_tree_node_and_element(a, rootElem);
 		unlink_tree_node_and_element(to_be_deleted, keepElem);
@@ -402,89 +404,68 @@ void UnionFindDeletion::DeleteFromReducedTree(TreeNodePtr a)
 		link_tree_node_and_element(a, keepElem);
 		link_tree_node_and_element(to_be_deleted, rootElem);
 		//element and treenodes doubly linked 
-		//update forest
-		//forest[a->elem->value] = forest[to_be_deleted->elem->value];
-		//forest.erase(to_be_deleted->elem->value);
 	}
 	//
-	if (to_be_deleted->parent != to_be_deleted) {
+	if (node(to_be_deleted).parent != to_be_deleted) {
 		RemoveFromCList(to_be_deleted);
 	}
 	//
 	RemoveFromDFSList(to_be_deleted);
 	//
-	to_be_deleted->elem->tree_node.reset();
-	//elemSet.erase(to_be_deleted->elem->value);
-	//
-	//if (to_be_deleted->parent == to_be_deleted)
-	//{// this is the root in the tree
-	// destroy this class 
+	forest->elem[to_be_deleted]->tree_node.reset();
 	//
-	//forest.erase(to_be_deleted->elem->value);
-	// 
-	//} 
-	//
-	//break cycles
-	to_be_deleted->elem.reset();
-	to_be_deleted->parent.reset();
-	to_be_deleted->cListHead.reset();
-	to_be_deleted->cPrev.reset();
-	to_be_deleted->cNext.reset();
-	to_be_deleted->nPrev.reset();
-	to_be_deleted->nNext.reset();
-	to_be_deleted->dfsPrev.reset();
-	to_be_deleted->dfsNext.reset();
+	free_node(to_be_deleted);
 
 	return;
 }
-void UnionFindDeletion::LocalRebuild(TreeNodePtr &p)
+void UnionFindDeletion::LocalRebuild(TreeIndex p)
 {
-	if (p->parent == p)
+	if (node(p).parent == p)
 	{// p is the root
 		// relink the three left most children of a non-leaf node c.
-		TreeRootNodePtr root = find_root(p);//forest[p->elem->value];
-		TreeNodePtr c = root->nListHead->nPrev;
+		TreeIndex root = find_root(p);
+		TreeIndex c = node(node(root).nListHead).nPrev;
 		//
-		if (c->cListSize < 6) {
-			while (c->cListSize > 0) {
-				Relink(c->cListHead->cPrev);
+		if (node(c).cListSize < 6) {
+			while (node(c).cListSize > 0) {
+				Relink(node(node(c).cListHead).cPrev);
 			}
 		}
 		else {
 			for (int i = 0; i < 3; i++) {
-				Relink(c->cListHead->cPrev);
+				Relink(node(node(c).cListHead).cPrev);
 			}
 		}
 	}
 	else {
-		if (p->cListSize < 5) {
-			while (p->cListSize > 0) {
-				Relink(p->cListHead->cPrev);
+		if (node(p).cListSize < 5) {
+			while (node(p).cListSize > 0) {
+				Relink(node(node(p).cListHead).cPrev);
 			}
 		}
 		else {
-			Relink(p->cListHead->cPrev);
-			Relink(p->cListHead->cPrev);
+			Relink(node(node(p).cListHead).cPrev);
+			Relink(node(node(p).cListHead).cPrev);
 		}
 	}
 	return;
 }
-void UnionFindDeletion::Delete(TreeNodePtr a)
+void UnionFindDeletion::Delete(TreeNodePtr a_node)
 {
+	TreeIndex a = a_node.index;
 	bool bReducedTree = true;
-	if (a->parent == a)
+	if (node(a).parent == a)
 	{// a is the root
-		TreeRootNodePtr root = find_root(a);//forest[a->elem->value]; 
-		if (root->nListHead){
+		if (node(a).nListHead){
 			bReducedTree = false;
 		}
 	}
 	else
 	{
-		if (a->parent->parent == a->parent)
+		TreeIndex p = node(a).parent;
+		if (node(p).parent == p)
 		{// a->parent is the root
-			TreeRootNodePtr root = find_root(a);//forest[a->parent->elem->value];
-			if (root->nListHead) {
+			if (node(p).nListHead) {
 				bReducedTree = false;
 			}
 		}
@@ -499,69 +480,47 @@ void UnionFindDeletion::Delete(TreeNodePtr a)
 	}
 	else
 	{
-		TreeNodePtr del = a;
+		TreeIndex del = a;
 		// find leaf
-		if (a->cListSize > 0)
+		if (node(a).cListSize > 0)
 		{
-			if (a->parent == a)
+			if (node(a).parent == a)
 			{// a is the root
-				del = a->dfsPrev;
-				//switch conents
-				ElementNodePtr keepElem = del->elem;
-				ElementNodePtr delElem = a->elem;
-
-				unlink_tree_node_and_element(a, delElem);
-				unlink_tree_node_and_element(del, keepElem);
-
-				link_tree_node_and_element(a, keepElem);
-				link_tree_node_and_element(del, delElem);
-				//
-				// update forest
-				//forest[a->elem->value] = forest[del->elem->value];
-				//forest.erase(del->elem->value);
+				del = node(a).dfsPrev;
 			}
 			else
 			{
-				if (a->cNext == a->parent->cListHead)
+				if (node(a).cNext == node(node(a).parent).cListHead)
 				{// no left sibling
-					del = a->dfsPrev;
+					del = node(a).dfsPrev;
 				}
 				else
 				{
-					del = a->cNext->dfsPrev;
+					del = node(node(a).cNext).dfsPrev;
 				}
-				//switch contents
-				ElementNodePtr keepElem = del->elem;
-				ElementNodePtr delElem = a->elem;
+			}
+			//switch contents
+			ElementNodePtr keepElem = forest->elem[del];
+			ElementNodePtr delElem = forest->elem[a];
 
-				unlink_tree_node_and_element(a, delElem);
-				unlink_tree_node_and_element(del, keepElem);
+			unlink_tree_node_and_element(a, delElem);
+			unlink_tree_node_and_element(del, keepElem);
 
-				link_tree_node_and_element(a, keepElem);
-				link_tree_node_and_element(del, delElem);
-			}
+			link_tree_node_and_element(a, keepElem);
+			link_tree_node_and_element(del, delElem);
 		}
 		//
-		TreeNodePtr delParent = del->parent;
+		TreeIndex delParent = node(del).parent;
 		// remove from CList
 		RemoveFromCList(del);
 		// remove from DFSList
 		RemoveFromDFSList(del);
 		//
-		del->elem->tree_node.reset();
-		//elemSet.erase(del->elem->value);
+		forest->elem[del]->tree_node.reset();
 		//  
 		LocalRebuild(delParent);
-		//break cycles
-		del->elem.reset();
-		del->parent.reset();
-		del->cListHead.reset();
-		del->cPrev.reset();
-		del->cNext.reset();
-		del->nPrev.reset();
-		del->nNext.reset();
-		del->dfsPrev.reset();
-		del->dfsNext.reset();
+		//
+		free_node(del);
 	}
 	return;
 }
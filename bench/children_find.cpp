@@ -0,0 +1,257 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// THIS SOFTWARE IS PROVIDED "AS-IS". THERE IS NO WARRANTY OF ANY KIND.
+// NEITHER THE AUTHORS NOR THE OHIO STATE UNIVERSITY WILL BE LIABLE
+// FOR ANY DAMAGES OF ANY KIND, EVEN IF ADVISED OF SUCH POSSIBILITY.
+//
+// Copyright (c) 2010 Jyamiti Research Group.
+// CS&E Department of the Ohio State University, Columbus, OH.
+// All rights reserved.
+//
+// Author: Sayan Mandal
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Microbenchmark of SimplicialTreeChildren::find against the unordered_map
+// the simplicial tree kept its children in before.
+//
+//   children_find <point file> <radius> [repetitions]
+//
+// First, random finds over 200k children, half of them hits, for a range
+// of fan-outs; this is where LINEAR_LIMIT comes from. Then, finds of every
+// simplex of the Rips 2-skeleton of the points, and of as many random
+// vertex tuples, descending the tree the way SimplicialTree::find does.
+// Rebuild with -DSIMPLICIAL_TREE_CHILDREN_LINEAR_LIMIT=<power of two> to
+// compare other limits.
+
+#include "SimplexNode.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+
+int max_dimension = 2;
+
+namespace
+{
+	// node of a simplicial tree with the children of the old layout
+	struct MapNode
+	{
+		std::unordered_map<int, MapNode *> children;
+	};
+
+	typedef std::chrono::steady_clock Clock;
+
+	double nanoseconds_since(Clock::time_point start, long operations) {
+		return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / operations;
+	}
+
+	typedef std::unordered_map<int, SimplicialTreeNode_ptr> ChildrenMap;
+
+	bool contains(SimplicialTreeChildren &children, const int label) {
+		return children.find(label) != children.end();
+	}
+
+	bool contains(ChildrenMap &children, const int label) {
+		return children.find(label) != children.end();
+	}
+
+	SimplicialTreeNode *child(SimplicialTreeNode *node, const int label) {
+		SimplicialTreeChildren::iterator it = node->children.find(label);
+		return it == node->children.end() ? NULL : it->second.get();
+	}
+
+	MapNode *child(MapNode *node, const int label) {
+		std::unordered_map<int, MapNode *>::iterator it = node->children.find(label);
+		return it == node->children.end() ? NULL : it->second;
+	}
+
+	template<class Node>
+	Node *find(Node *root, const std::vector<int> &simplex) {
+		Node *node = root;
+		for (size_t i = 0; i < simplex.size() && node != NULL; i++)
+			node = child(node, simplex[i]);
+		return node;
+	}
+
+	template<class Node>
+	long find_all(Node *root, const std::vector<std::vector<int> > &queries, const int repetitions) {
+		long found = 0;
+		for (int r = 0; r < repetitions; r++) {
+			for (size_t i = 0; i < queries.size(); i++)
+				found += find(root, queries[i]) != NULL;
+		}
+		return found;
+	}
+
+	void benchmark_fan_outs(std::mt19937 &generator) {
+		const int CHILDREN = 200000;
+		const int QUERIES = 2000000;
+		const int fan_outs[] = { 1, 2, 4, 6, 8, 12, 16, 32, 128, 1024 };
+
+		printf("fan-out  SimplicialTreeChildren  unordered_map  (ns per find)\n");
+		for (size_t f = 0; f < sizeof(fan_outs) / sizeof(fan_outs[0]); f++) {
+			const int fan_out = fan_outs[f];
+			const int nodes = CHILDREN / fan_out;
+
+			// the containers alone, so that both sides touch the same
+			// number of cache lines outside the children
+			std::vector<SimplicialTreeChildren> children(nodes);
+			std::vector<ChildrenMap> maps(nodes);
+			std::vector<std::vector<int> > labels(nodes);
+			std::uniform_int_distribution<int> random_label(0, 1 << 20);
+			for (int n = 0; n < nodes; n++) {
+				while ((int)labels[n].size() < fan_out) {
+					int label = random_label(generator);
+					if (std::find(labels[n].begin(), labels[n].end(), label) != labels[n].end())
+						continue;
+					labels[n].push_back(label);
+					children[n][label] = SimplicialTreeNode_ptr();
+					maps[n][label] = SimplicialTreeNode_ptr();
+				}
+			}
+
+			// ( node, label ), half of them children
+			std::vector<std::pair<int, int> > queries(QUERIES);
+			std::uniform_int_distribution<int> random_node(0, nodes - 1);
+			std::uniform_int_distribution<int> random_child(0, fan_out - 1);
+			for (int q = 0; q < QUERIES; q++) {
+				int n = random_node(generator);
+				queries[q] = std::make_pair(n, q % 2 == 0 ? labels[n][random_child(generator)] : random_label(generator));
+			}
+
+			long found[2] = { 0, 0 };
+			Clock::time_point start = Clock::now();
+			for (int q = 0; q < QUERIES; q++)
+				found[0] += contains(children[queries[q].first], queries[q].second);
+			double children_ns = nanoseconds_since(start, QUERIES);
+
+			start = Clock::now();
+			for (int q = 0; q < QUERIES; q++)
+				found[1] += contains(maps[queries[q].first], queries[q].second);
+			double map_ns = nanoseconds_since(start, QUERIES);
+
+			if (found[0] != found[1]) {
+				printf("MISMATCH at fan-out %d\n", fan_out);
+				exit(1);
+			}
+			printf("%7d  %22.1f  %13.1f\n", fan_out, children_ns, map_ns);
+		}
+	}
+
+	bool read_points(const char *path, std::vector<std::vector<double> > &points) {
+		std::ifstream file(path);
+		int dimensions, size;
+		if (!(file >> dimensions >> size))
+			return false;
+		points.assign(size, std::vector<double>(dimensions));
+		for (int i = 0; i < size; i++) {
+			for (int d = 0; d < dimensions; d++)
+				file >> points[i][d];
+		}
+		return (bool)file;
+	}
+
+	// simplices of the Rips 2-skeleton, vertices sorted
+	void rips_complex(const std::vector<std::vector<double> > &points, const double radius,
+		std::vector<std::vector<int> > &simplices) {
+		const int n = (int)points.size();
+		std::vector<std::vector<bool> > is_edge(n, std::vector<bool>(n, false));
+		for (int i = 0; i < n; i++) {
+			simplices.push_back(std::vector<int>(1, i));
+			for (int j = i + 1; j < n; j++) {
+				double squared = 0;
+				for (size_t d = 0; d < points[i].size(); d++)
+					squared += (points[i][d] - points[j][d]) * (points[i][d] - points[j][d]);
+				is_edge[i][j] = is_edge[j][i] = std::sqrt(squared) <= radius;
+			}
+		}
+		for (int i = 0; i < n; i++) {
+			for (int j = i + 1; j < n; j++) {
+				if (!is_edge[i][j])
+					continue;
+				simplices.push_back({ i, j });
+				for (int k = j + 1; k < n; k++) {
+					if (is_edge[i][k] && is_edge[j][k])
+						simplices.push_back({ i, j, k });
+				}
+			}
+		}
+	}
+
+	void benchmark_rips(const std::vector<std::vector<double> > &points, const double radius,
+		const int repetitions, std::mt19937 &generator) {
+		std::vector<std::vector<int> > simplices;
+		rips_complex(points, radius, simplices);
+
+		// the faces of a simplex come before it
+		SimplicialTreeNodePool pool(1);
+		std::deque<MapNode> map_nodes(1);
+		for (size_t s = 0; s < simplices.size(); s++) {
+			const std::vector<int> &simplex = simplices[s];
+			SimplicialTreeNode *node = find(&pool[0], std::vector<int>(simplex.begin(), simplex.end() - 1));
+			MapNode *map_node = find(&map_nodes[0], std::vector<int>(simplex.begin(), simplex.end() - 1));
+
+			pool.push_back(SimplicialTreeNode(simplex.back()));
+			node->children[simplex.back()] = SimplicialTreeNode_ptr(&pool.back());
+			map_nodes.push_back(MapNode());
+			map_node->children[simplex.back()] = &map_nodes.back();
+		}
+
+		std::vector<std::vector<int> > queries(simplices);
+		std::uniform_int_distribution<int> random_vertex(0, (int)points.size() - 1);
+		for (size_t s = 0; s < simplices.size(); s++) {
+			std::vector<int> tuple;
+			while (tuple.size() < simplices[s].size()) {
+				int vertex = random_vertex(generator);
+				if (std::find(tuple.begin(), tuple.end(), vertex) == tuple.end())
+					tuple.push_back(vertex);
+			}
+			std::sort(tuple.begin(), tuple.end());
+			queries.push_back(tuple);
+		}
+		std::shuffle(queries.begin(), queries.end(), generator);
+
+		const long operations = (long)queries.size() * repetitions;
+		Clock::time_point start = Clock::now();
+		long found = find_all(&pool[0], queries, repetitions);
+		double children_ns = nanoseconds_since(start, operations);
+
+		start = Clock::now();
+		long map_found = find_all(&map_nodes[0], queries, repetitions);
+		double map_ns = nanoseconds_since(start, operations);
+
+		if (found != map_found) {
+			printf("MISMATCH in the Rips complex\n");
+			exit(1);
+		}
+		printf("Rips 2-skeleton, radius %g: %d simplices, %ld of %d queries found\n",
+			radius, (int)simplices.size(), found / repetitions, (int)queries.size());
+		printf("  SimplicialTreeChildren %.1f ns, unordered_map %.1f ns per find\n", children_ns, map_ns);
+	}
+}
+
+int main(int argc, char **argv) {
+	if (argc < 3) {
+		printf("Usage: %s <point file> <radius> [repetitions]\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<std::vector<double> > points;
+	if (!read_points(argv[1], points)) {
+		printf("Cannot read points from %s\n", argv[1]);
+		return 1;
+	}
+	const double radius = atof(argv[2]);
+	const int repetitions = argc > 3 ? atoi(argv[3]) : 20;
+
+	std::mt19937 generator(1);
+	printf("LINEAR_LIMIT %d\n", SIMPLICIAL_TREE_CHILDREN_LINEAR_LIMIT);
+	benchmark_fan_outs(generator);
+	benchmark_rips(points, radius, repetitions, generator);
+
+	return 0;
+}
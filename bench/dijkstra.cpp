@@ -0,0 +1,243 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// THIS SOFTWARE IS PROVIDED "AS-IS". THERE IS NO WARRANTY OF ANY KIND.
+// NEITHER THE AUTHORS NOR THE OHIO STATE UNIVERSITY WILL BE LIABLE
+// FOR ANY DAMAGES OF ANY KIND, EVEN IF ADVISED OF SUCH POSSIBILITY.
+//
+// Copyright (c) 2010 Jyamiti Research Group.
+// CS&E Department of the Ohio State University, Columbus, OH.
+// All rights reserved.
+//
+// Author: Sayan Mandal
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Microbenchmark of per-source Dijkstra on the Rips graph of a point set,
+// with Headers::Dary_heap against the boost::mutable_queue the shortest
+// path searches used before. Every source is run once on both queues
+// first, and the distances have to agree.
+//
+//   dijkstra <point file> <radius> [repetitions]
+
+#include <Dary_heap.h>
+
+#include <boost/pending/mutable_queue.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	typedef std::vector< std::vector< std::pair< unsigned, double > > > Graph;
+
+	// Orders vertex indices by distance, as Pointee_distance_to_root_is_less
+	// ordered the vertices
+	struct Distance_is_less
+	{
+		std::vector< double > const *p_distances;
+
+		bool operator()( unsigned a_, unsigned b_ ) const
+		{
+			return ( *p_distances )[ a_ ] < ( *p_distances )[ b_ ];
+		}
+	};
+
+	struct Identity_map
+		: public boost::put_get_helper< std::size_t, Identity_map >
+	{
+		typedef unsigned key_type;
+		typedef std::size_t value_type;
+		typedef std::size_t reference;
+		typedef boost::readable_property_map_tag category;
+
+		std::size_t operator[]( unsigned key_ ) const
+		{
+			return key_;
+		}
+	};
+
+	void dijkstra_mutable_queue( Graph const &graph_, unsigned source_,
+		std::vector< double > &distances_ )
+	{
+		distances_.assign( graph_.size(), INFINITY );
+		std::vector< char > is_in_queue( graph_.size(), 0 );
+		std::vector< char > is_in_tree( graph_.size(), 0 );
+
+		Distance_is_less is_less = { &distances_ };
+		boost::mutable_queue< unsigned, std::vector< unsigned >,
+			Distance_is_less, Identity_map > queue( graph_.size(), is_less,
+			Identity_map() );
+
+		distances_[ source_ ] = 0;
+		queue.push( source_ );
+		is_in_queue[ source_ ] = 1;
+
+		while ( !queue.empty() )
+		{
+			unsigned current( queue.top() );
+			queue.pop();
+			is_in_queue[ current ] = 0;
+			is_in_tree[ current ] = 1;
+
+			for ( unsigned i( 0 ); i != graph_[ current ].size(); ++i )
+			{
+				unsigned neighbor( graph_[ current ][ i ].first );
+				if ( is_in_tree[ neighbor ] )
+					continue;
+
+				double distance( distances_[ current ] + graph_[ current ][ i ].second );
+				if ( distance < distances_[ neighbor ] )
+				{
+					distances_[ neighbor ] = distance;
+					if ( is_in_queue[ neighbor ] )
+						queue.update( neighbor );
+					else
+					{
+						is_in_queue[ neighbor ] = 1;
+						queue.push( neighbor );
+					}
+				}
+			}
+		}
+	}
+
+	void dijkstra_dary_heap( Graph const &graph_, unsigned source_,
+		std::vector< double > &distances_, Headers::Dary_heap &queue_ )
+	{
+		distances_.assign( graph_.size(), INFINITY );
+		std::vector< char > is_in_tree( graph_.size(), 0 );
+
+		distances_[ source_ ] = 0;
+		queue_.push( source_, 0 );
+
+		while ( !queue_.empty() )
+		{
+			unsigned current( queue_.top() );
+			queue_.pop();
+			is_in_tree[ current ] = 1;
+
+			for ( unsigned i( 0 ); i != graph_[ current ].size(); ++i )
+			{
+				unsigned neighbor( graph_[ current ][ i ].first );
+				if ( is_in_tree[ neighbor ] )
+					continue;
+
+				double distance( distances_[ current ] + graph_[ current ][ i ].second );
+				if ( distance < distances_[ neighbor ] )
+				{
+					distances_[ neighbor ] = distance;
+					if ( queue_.contains( neighbor ) )
+						queue_.decrease( neighbor, distance );
+					else
+						queue_.push( neighbor, distance );
+				}
+			}
+		}
+	}
+
+	// Returns the number of edges
+	unsigned read_rips_graph( char const *path_, double radius_, Graph &graph_ )
+	{
+		std::ifstream file( path_ );
+		unsigned dimensions( 0 ), size( 0 );
+		file >> dimensions >> size;
+
+		std::vector< std::vector< double > > points( size,
+			std::vector< double >( dimensions ) );
+		for ( unsigned i( 0 ); i != size; ++i )
+		{
+			for ( unsigned d( 0 ); d != dimensions; ++d )
+				file >> points[ i ][ d ];
+		}
+
+		if ( !file )
+		{
+			printf( "Cannot read points from %s\n", path_ );
+			exit( 1 );
+		}
+
+		graph_.assign( size, std::vector< std::pair< unsigned, double > >() );
+		unsigned number_of_edges( 0 );
+		for ( unsigned i( 0 ); i != size; ++i )
+		{
+			for ( unsigned j( i + 1 ); j != size; ++j )
+			{
+				double squared( 0 );
+				for ( unsigned d( 0 ); d != dimensions; ++d )
+					squared += ( points[ i ][ d ] - points[ j ][ d ] )
+						* ( points[ i ][ d ] - points[ j ][ d ] );
+
+				double length( std::sqrt( squared ) );
+				if ( length > radius_ )
+					continue;
+
+				graph_[ i ].push_back( std::make_pair( j, length ) );
+				graph_[ j ].push_back( std::make_pair( i, length ) );
+				++number_of_edges;
+			}
+		}
+
+		return number_of_edges;
+	}
+}
+
+int main( int argc, char **argv )
+{
+	using namespace std;
+
+	if ( argc < 3 )
+	{
+		printf( "Usage: %s <point file> <radius> [repetitions]\n", argv[ 0 ] );
+		return 1;
+	}
+
+	double radius( atof( argv[ 2 ] ) );
+	unsigned repetitions( argc > 3 ? atoi( argv[ 3 ] ) : 20 );
+
+	Graph graph;
+	unsigned number_of_edges( read_rips_graph( argv[ 1 ], radius, graph ) );
+	unsigned size( graph.size() );
+
+	vector< double > expected, distances;
+	Headers::Dary_heap queue( size );
+	for ( unsigned source( 0 ); source != size; ++source )
+	{
+		dijkstra_mutable_queue( graph, source, expected );
+		dijkstra_dary_heap( graph, source, distances, queue );
+		if ( distances != expected )
+		{
+			printf( "MISMATCH from source %u\n", source );
+			return 1;
+		}
+	}
+
+	typedef chrono::steady_clock Clock;
+
+	Clock::time_point start( Clock::now() );
+	for ( unsigned r( 0 ); r != repetitions; ++r )
+	{
+		for ( unsigned source( 0 ); source != size; ++source )
+			dijkstra_mutable_queue( graph, source, distances );
+	}
+	Clock::time_point middle( Clock::now() );
+	for ( unsigned r( 0 ); r != repetitions; ++r )
+	{
+		for ( unsigned source( 0 ); source != size; ++source )
+			dijkstra_dary_heap( graph, source, distances, queue );
+	}
+	Clock::time_point end( Clock::now() );
+
+	double runs( double( repetitions ) * size );
+	printf( "%s radius %g: %u vertices, %u edges\n", argv[ 1 ], radius, size,
+		number_of_edges );
+	printf( "  mutable_queue %.1f us, Dary_heap %.1f us per source\n",
+		chrono::duration< double, micro >( middle - start ).count() / runs,
+		chrono::duration< double, micro >( end - middle ).count() / runs );
+
+	return 0;
+}
@@ -13,6 +13,14 @@
 # clean:
 # 	\rm -f *.o trackLoop
 
+# sh build.sh bench builds the microbenchmarks in bench/, one binary each
+if [ "$1" = "bench" ]; then
+	for f in bench/*.cpp; do
+		g++ -O3 -I. -I./Headers -o ${f%.cpp} --std=c++11 $f || exit 1
+	done
+	exit 0
+fi
+
 LIBS="-I/usr/local/include -I/usr/local/include/eigen3 -static -Igmpq -lCGAL -Igmp -lgmp -lann -lboost_system -lboost_filesystem -lboost_program_options -lboost_thread -lpthread"
 
 g++ -O3 -frounding-math -I. -I./Headers -o trackLoop --std=c++11  *.cpp  $LIBS
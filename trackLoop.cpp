@@ -33,6 +33,7 @@
 #include <boost/filesystem.hpp>
 #include <boost/timer.hpp>
 #include <boost/progress.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include <CGAL/Cartesian.h>
 
@@ -40,8 +41,13 @@
 #include <Legal.h>
 #include "SimplicialComplex.h"
 #include "Complex.h"
+#include "LoopTracker.h"
+#include "LoopStore.h"
+#include "LoopWriter.h"
 #include <OFF_input_file.h>
 #include <OFF_output_file.h>
+#include <Filtration_input_file.h>
+#include <Filtration_output_file.h>
 
 // #ifndef COMPLEX_H
 // #define COMPLEX_H
@@ -91,11 +97,17 @@ int input_type_flag;
 
 // outer vector: loop, inner vector: edges forming the loop
 typedef std::vector<std::vector<int>> higherOrder;
-typedef std::vector<std::vector<std::vector<float>>> higherPoint;
+
+// what happens to a dimension-1 bar at a filtration index
+struct barEvent{
+	enum { NONE, BORN, DEAD } kind;
+	int bar;	//index into vborn/vdead
+};
 
 // void createTreeLoopTracker_ptr(std::vector<std::vector<std::vector<int>>> simplex_vertices);
 bool CheckBoundary (std::vector<std::vector<int>> simplex_vertices);
-void CheckBoundaryBirthOfLoops(std::map<int, higherOrder> birthOfLoops);
+void CheckBoundaryBirthOfLoops(const LoopStore &birthOfLoops, const LoopTracker &tracker);
+AnnotationVector loopAnnotation(const std::vector<int> &endpoints);
 // ListNodeptr AddBoundary(std::vector<std::vector<int>> simplex_vertices);
 // int independantCycleCalculate2(std::map<float,int> weights, std::vector<std::vector<std::vector<int>>> higher_simplex);
 int independantCycleCalculate(std::multimap<float, higherOrder> &simp_weight);
@@ -109,7 +121,7 @@ void ComputingPersistenceForSimplicialMapElementary(vector<vector<int> > simplex
 	bool is_save_range_complex_with_annotation = false,
 	const char* new_range_complex_file_name = NULL);
 
-bool bornTracker(higherOrder simp2, std::map<int, higherOrder> birthOfLoops);
+bool bornTracker(const std::vector<int> &simp2, const LoopStore &birthOfLoops, const LoopTracker &tracker);
 
 
 bool barcodeCompare(const pair<int, int>& a, const pair<int, int>& b)
@@ -139,6 +151,12 @@ void printHigherOrder(higherOrder ho){
 	cout<<"\n";
 }
 
+void printLoop(const int *endpoints, int nEdges){
+	for(int i=0;i<nEdges;i++)
+		cout<<endpoints[2*i]<<" "<<endpoints[2*i+1]<<" <-->";
+	cout<<"\n";
+}
+
 
 void printMultimap(std::multimap<float, higherOrder> simp_weight, int op){
 	int countitsw = 0;
@@ -153,174 +171,59 @@ void printMultimap(std::multimap<float, higherOrder> simp_weight, int op){
 
 }
 
-bool checkPoints(std::vector<float> a, std::vector<float> b){
-	for(int i=0;i<a.size();i++)
-		if(a[i]!=b[i])
-			return false;
-	return true;
-}
-
-higherPoint modifylastloopPoint(higherPoint lastLoop){
-	higherPoint temp;
-	temp.push_back(lastLoop[0]);
-	lastLoop.erase(lastLoop.begin());
-
-	int count = 1;
-	int fullsize = lastLoop.size();
-	while(count<=fullsize){
-		std::vector<float> a;
-		a.push_back(temp[temp.size()-1][1][0]);
-		a.push_back(temp[temp.size()-1][1][1]);
-		a.push_back(temp[temp.size()-1][1][2]);
-		// Point a = temp[temp.size()-1][1];	//last element in last edge of vector, last vertex;
-		int k;
-		for(k=0;k<lastLoop.size();k++)	{
-			if(checkPoints(lastLoop[k][1],a)==true ||checkPoints(lastLoop[k][0],a)==true)
-				break;
-		}
-		if(checkPoints(lastLoop[k][1],a))		//need to reverse the edge
-			{	std::vector<std::vector<float>> tttt;
-				tttt.push_back(lastLoop[k][1]);
-				tttt.push_back(lastLoop[k][0]);
-				temp.push_back(tttt);
-			}
-		else
-			temp.push_back(lastLoop[k]);
-		lastLoop.erase(lastLoop.begin() + k);
-		// cout<<"2";
-		count++;
-	// // getchar();
-
+// orders the edges of a loop so that each one starts where the previous one ends
+std::vector<int> modifylastloop(const int *endpoints, int nEdges){
+	for(int i=0;i<nEdges;i++){
+		cout<<endpoints[2*i]<<" "<<endpoints[2*i+1];
+		cout<<"-+-";
 	}
-	return temp;
-	
-}
 
-higherOrder modifylastloop(higherOrder lastLoop){
-	higherOrder temp;
-	for(int i=0;i<lastLoop.size();i++){
-		// for(int j=0;j<lastLoop[i].size();j++){
-			if(lastLoop[i].size()!=2)
-				{cout<<"error"; exit(0);}
-			cout<<lastLoop[i][0]<<" "<<lastLoop[i][1];
-			cout<<"-+-";
-		}
-
-	temp.push_back(lastLoop[0]);
-	lastLoop.erase(lastLoop.begin());
+	std::vector<int> temp(endpoints, endpoints+2);
+	std::vector<int> lastLoop(endpoints+2, endpoints+2*nEdges);
 	int count = 1;
-	int fullsize = lastLoop.size();
+	int fullsize = nEdges-1;
 	while(count<=fullsize){
-		int a = temp[temp.size()-1][1];	//last element in last edge of vector, last vertex;
-		int k;
-		for(k=0;k<lastLoop.size();k++)
-			if(lastLoop[k][1]==a ||lastLoop[k][0]==a)
+		int a = temp.back();	//last element in last edge of vector, last vertex;
+		size_t k;
+		for(k=0;2*k<lastLoop.size();k++)
+			if(lastLoop[2*k+1]==a ||lastLoop[2*k]==a)
 				break;
-			else if(k==lastLoop.size()-1)
+			else if(2*k+2==lastLoop.size())
 			{
 				cout<<"Loop mismatch: "<<a<<" ";
-				for (int it = 0; it < temp.size(); ++it)
-					cout<<temp[it][0]<<" "<<temp[it][1]<<"|";
+				for (size_t it = 0; it < temp.size(); it+=2)
+					cout<<temp[it]<<" "<<temp[it+1]<<"|";
 				cout<<"\n";
-				for (int it = 0; it < lastLoop.size(); ++it)
-					cout<<lastLoop[it][0]<<" "<<lastLoop[it][1]<<"|";
+				for (size_t it = 0; it < lastLoop.size(); it+=2)
+					cout<<lastLoop[it]<<" "<<lastLoop[it+1]<<"|";
 				exit(0);
 			}
 
-		if(lastLoop[k][1]==a)		//need to reverse the edge
+		if(lastLoop[2*k+1]==a)		//need to reverse the edge
 			{	
-				std::vector<int> tttt;
-				tttt.push_back(lastLoop[k][1]);
-				tttt.push_back(lastLoop[k][0]);
-				temp.push_back(tttt);
-				
+				temp.push_back(lastLoop[2*k+1]);
+				temp.push_back(lastLoop[2*k]);
 			}
-		else if(lastLoop[k][0]==a){
-			cout<<"higherOrder size 5:"<<lastLoop.size();
-			// getchar(); 
-			temp.push_back(lastLoop[k]);
+		else if(lastLoop[2*k]==a){
+			cout<<"higherOrder size 5:"<<lastLoop.size()/2;
+			temp.push_back(lastLoop[2*k]);
+			temp.push_back(lastLoop[2*k+1]);
 		}
 		else
 		{
 			cout<<"Loop mismatch"; exit(0);
 		}
 
-			cout<<"higherOrder size 3:"<<lastLoop.size();
-	// getchar();
+			cout<<"higherOrder size 3:"<<lastLoop.size()/2;
 
-		lastLoop.erase(lastLoop.begin() + k);
-		// cout<<"2";
+		lastLoop.erase(lastLoop.begin() + 2*k, lastLoop.begin() + 2*k + 2);
 		count++;
-	// getchar();
-
 	}
 	return temp;
 	
 }
 
-void loopPrinting( std::map<int,higherPoint> vloop_all, std::string loops_folder){
-
-//higherpoint: vector, vector , vector float
-	boost::filesystem::path dir(loops_folder.c_str());
-	boost::filesystem::create_directory(dir);
-	// std::vector<higherOrder> vInd;
-	// const int dir_err = mkdir(loops_folder.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
-	// if (-1 == dir_err)
-	// {
-	//     printf("Error creating directory!n");
-	//     exit(1);
-	// }
-	// chmod("./myfile", S_IRWXU);
-	higherOrder vInd;
-	
-	// for(int l1=0;l1<vloop.size();l1++)
-	for(std::map<int,higherPoint>::iterator iter = vloop_all.begin(); iter != vloop_all.end(); ++iter)
-	{
-		std::vector<int> edge;
-		int k =  iter->first;
-		higherPoint vloop = iter->second;
-	// {
-		std::string file = loops_folder+std::to_string(k)+".off";
-		cout<<"OFF folder:"<<file<<"\n";
-		ofstream ofloop(file.c_str());
-		ofloop<<"OFF"<<std::endl<<vloop.size()*4<<" "<<vloop.size()<<" 0\n";
-		int count = 0;
-		for(int l2=0;l2<vloop.size();l2++){
-			// if(vloop[l1][l2][0].size()!=3 || vloop[l1][l2][1].size()!=3){
-			// cout<<"Cannot print loop, not 3D";
-			// exit(0);
-			// }
-		ofloop<<vloop[l2][0][0]<<" "<<vloop[l2][0][1]<<" "<<vloop[l2][0][2]<<"\n";
-		ofloop<<vloop[l2][1][0]<<" "<<vloop[l2][1][1]<<" "<<vloop[l2][1][2]<<"\n";
-		ofloop<<vloop[l2][0][0]<<" "<<vloop[l2][0][1]<<" "<<vloop[l2][0][2]<<"\n";
-		ofloop<<vloop[l2][1][0]<<" "<<vloop[l2][1][1]<<" "<<vloop[l2][1][2]<<"\n";
-
-		edge.push_back(count++);
-		edge.push_back(count++);
-		edge.push_back(count++);
-		edge.push_back(count++);
-		vInd.push_back(edge);
-		edge.clear();
-		// ofloop<<"#######################################################\n";
-
-		}
-
-		for(int ed=0;ed<vInd.size();ed++)
-		{
-			ofloop<<"4 "<<vInd[ed][0]<<" "<<vInd[ed][1]<<" "<<vInd[ed][2]<<" "<<vInd[ed][3]<<" 1.0 1.0 0.0"<<std::endl;
-		}
-
-		ofloop.close();
-		vInd.clear();
-
-	}
-	// count = 0;
-
-	
-}
-
-
-int simpersPart(std::vector<int>  &born,std::vector<int>  &dead, std::string simpers_file){
+int simpersPart(std::vector<int>  &born,std::vector<int>  &dead, std::vector<barEvent> &events, std::string simpers_file){
 
 	ifstream ff(simpers_file.c_str());
     // cout<<"simpers part";
@@ -337,7 +240,7 @@ int simpersPart(std::vector<int>  &born,std::vector<int>  &dead, std::string sim
     	char sLine[256]="";
     	ff.getline(sLine, 256);
     	if(sLine==""||strlen(sLine)==0)
-    		return 0;
+    		break;
     	// cout<<sLine<<",,,, ";
     	stringstream ss;
 		ss.str(sLine);
@@ -347,7 +250,7 @@ int simpersPart(std::vector<int>  &born,std::vector<int>  &dead, std::string sim
     	if(dim==0)
     		continue;
     	if(dim==2)
-    		return 0;
+    		break;
     	born.push_back(fborn);
     	// cout<<fborn<<"fb ";
     	if(fdead == "inf")
@@ -358,28 +261,74 @@ int simpersPart(std::vector<int>  &born,std::vector<int>  &dead, std::string sim
     	// cout<<fdead<<"fd"<<"\n";
 
     }
+
+    // Markers of the filtration file are looked up by index, so the bars
+    // are laid out in a table with one entry per filtration index. A death
+    // shadows a birth at the same index, and the first bar wins on ties.
+    int last = -1;
+    for(size_t i=0;i<born.size();i++)
+    	last = std::max(last, std::max(born[i], dead[i]));
+    events.assign(last+1, barEvent());
+    for(size_t i=0;i<born.size();i++)
+    	if(born[i]>=0 && events[born[i]].kind==barEvent::NONE){
+    		events[born[i]].kind = barEvent::BORN;
+    		events[born[i]].bar = i;
+    	}
+    for(size_t i=0;i<dead.size();i++)
+    	if(dead[i]>=0 && events[dead[i]].kind!=barEvent::DEAD){
+    		events[dead[i]].kind = barEvent::DEAD;
+    		events[dead[i]].bar = i;
+    	}
     return 0;
 }
 
 
-int loopExistenceChecker(higherOrder simp2, std::map<int, higherOrder> birthOfLoops){
+// Writes the filtration in the binary format, which the main loop reads
+// without any text parsing; index_markers appends the marker index
+int convertFiltration(std::string filtration_file, std::string binary_filtration_file, bool index_markers){
+
+	try
+	{
+		Headers::Filtration_input_file input(filtration_file.c_str());
+		Headers::Filtration_output_file output(binary_filtration_file.c_str(), index_markers);
+
+		Headers::Filtration_record record;
+		int count = 0;
+		while(input.read(record)){
+			output.write(record);
+			count++;
+		}
+		output.close();
+
+		cout<<"Converted "<<count<<" records of "<<filtration_file<<" to "<<binary_filtration_file<<"\n";
+	}
+	catch(Headers::Exception &e)
+	{
+		cout<<e.what()<<"\n";
+		return 1;
+	}
+	return 0;
+}
+
+
+// Writes the finished persistence pairs of every dimension and drops them,
+// so that only the pages of classes still alive stay in memory; bAll also
+// writes the alive ones, once the filtration is over
+void flushPersistencePairs(std::ostream &os, bool bAll = false){
+	for(size_t dim = 0; dim < persistences.size(); dim++)
+		persistences[dim].flush(os, (int)dim, bAll);
+}
+
+
+int loopExistenceChecker(const std::vector<int> &simp2, const LoopStore &birthOfLoops){
 	//true: it already exists. danger
 	// false: new one does not exist.
-	// int iterator=0;
-	for(std::map<int,higherOrder>::iterator iter = birthOfLoops.begin(); iter != birthOfLoops.end(); ++iter)
+	for(LoopStore::const_iterator iter = birthOfLoops.begin(); iter != birthOfLoops.end(); ++iter)
 	{
-		bool flag = false;
-		higherOrder buff = iter->second ;
-		if(buff.size()!=simp2.size())
+		if(2*birthOfLoops.edge_count(iter->first)!=(int)simp2.size())
 			continue;
-		for(int ord=0;ord<buff.size();ord++){
-			if(buff[ord][0]!=simp2[ord][0] || buff[ord][0] != simp2[ord][1] )
-				break;
-			else if(ord==buff.size()-1)
-				return iter->first;
-		}
-		// iterator++;
-
+		if(std::equal(simp2.begin(), simp2.end(), birthOfLoops.endpoints(iter->first)))
+			return iter->first;
 	}
 	return -1;
 }// end of loopExistenceChecker
@@ -391,36 +340,46 @@ int main( int argc, char *argv[] )
 	// std::string output_persistence_file_name;
 	std::string loops_folder;
 	std::string filtration_file;
+	std::string binary_filtration_file;
+	bool index_markers = false;
 	// std::string output_file;
 	std::string point_file;
 	std::string simpers_file;
+	std::string pairs_file;
 	string input_file_name;
 	double alpha=INFINITY;
 	bool bDeathTimeOrder = true;
 	bool bTimeStamp = false;
 	float fMaxScale = 0.0;
 	double sampling_coefficient = 1;
+	unsigned number_of_threads = 1;
+	bool full_basis = false;
 	// float born, dead;
 	std::vector<int> vborn;
 	std::vector<int> vdead;
-	std::map<int, higherPoint> vloop;	//Point, two points: one edge, set of edge: one cycle, set of cycle: against birth-time
+	std::vector<barEvent> vevents;	//bar event at each filtration index
 
 	int dimensions, noPoints; 
 	float scalecount = 0;
 	std::vector<Point> allPts;
-	higherOrder storeComplexforShortLoop; // stores entire complex to be pushed into shortloop
-	std::map<int, higherOrder> birthOfLoops;	//int: birth time, higherOrder: edges in the loop
+	LoopStore birthOfLoops;	//alive loops against birth time
+	LoopTracker loopTracker;	//annotations of the loops in birthOfLoops
 	std::map<int, int> nedges; //number of edges
 
 
 	ParseCommand(argc, argv, input_pointcloud_file, 
-		filtration_file, sampling_coefficient);
+		filtration_file, sampling_coefficient, number_of_threads, full_basis,
+		binary_filtration_file, index_markers);
+
+	if(!binary_filtration_file.empty())
+		return convertFiltration(filtration_file, binary_filtration_file, index_markers);
 	// born = 100;
 	// dead = 100;
 
     // ifstream f(input_pointcloud_file.c_str());
     simpers_file = input_pointcloud_file.substr(0,input_pointcloud_file.size()-4)+"pers.txt"; //Input to simpers
     loops_folder = input_pointcloud_file.substr(0,input_pointcloud_file.size()-4)+"loops/"; //Output of loops
+    pairs_file = input_pointcloud_file.substr(0,input_pointcloud_file.size()-4)+"pairs.txt"; //Output of persistence pairs
     ifstream pf(input_pointcloud_file.c_str());
 
     
@@ -431,20 +390,23 @@ int main( int argc, char *argv[] )
         return 0;
     }
 
-	ifstream ff(filtration_file.c_str());
 	// string barnumber = filtration_file+"_pers";
 	// ofstream ff2((filtration_file+"_pers").c_str());
-	if(ff.good()==false)
-    {
-        cout<<"Filtration file does not exist.";
-        exit(0);
-    }
+	boost::scoped_ptr<Headers::Filtration_input_file> p_filtration;
+	try
+	{
+		p_filtration.reset(new Headers::Filtration_input_file(filtration_file.c_str()));
+	}
+	catch(Headers::Exception &e)
+	{
+		cout<<"Filtration file does not exist.";
+		exit(0);
+	}
 
     typedef Cartesian< double > Kernel;
     
 
-    simpersPart(vborn, vdead, simpers_file);
-    // vloop.reserve(vborn.size());
+    simpersPart(vborn, vdead, vevents, simpers_file);
 	//OFF_input_file< Kernel > input( input_pointcloud_file.c_str() );    
 	// vborn, vdead, 
 	
@@ -453,7 +415,10 @@ int main( int argc, char *argv[] )
 	pf >> noPoints;
 	cout<<"Dim: "<<dimensions<<" #Pt: "<<noPoints<<" \n";
 	bool verbose = true;
-	// Complex< Kernel > complex( dimensions, verbose );		
+	// The shortest basis complex grows with the filtration; its contraction
+	// is kept up to date so that born events do not rebuild it
+	Complex< Kernel > complex( dimensions, verbose );
+	complex.set_number_of_threads( number_of_threads );
 	const char* buff = '\0';
 
 	vector<string> vecElemOpers;
@@ -462,7 +427,15 @@ int main( int argc, char *argv[] )
 	
 	// Create vertices SHORTLOOP
 
+	// "dim birth death" lines, flushed every PAIRS_FLUSH_INTERVAL steps
+	ofstream pairsOut(pairs_file.c_str());
+	const int PAIRS_FLUSH_INTERVAL = 4096;
+
 	domain_complex.bGenerator = false;
+	domain_complex.EnableSimplexIndex();
+	domain_complex.cocycle_killed = [&loopTracker](const int simplex_dim, const int u, const AnnotationColumnPtr &sum){
+		loopTracker.kill_cocycle(simplex_dim, u, sum);
+	};
 	for ( int itp=0; itp < noPoints; itp++ )
 	{			
 		Point p(dimensions);
@@ -472,8 +445,8 @@ int main( int argc, char *argv[] )
 			p.set_coord(k,coord);
 		}
 		
-		// Vertex< Kernel > *p_vertex( new Vertex< Kernel >(p));
-		// complex.insert_vertex( p_vertex );
+		Vertex< Kernel > *p_vertex( new Vertex< Kernel >(p));
+		complex.insert_vertex( p_vertex );
 		scalecount+=1;
 		filtration_step += 1;
 		timer2 = std::clock();
@@ -490,12 +463,16 @@ int main( int argc, char *argv[] )
 
 	}
 
+	// Loops are written as soon as they die, the essential ones at the end
+	LoopWriter loopWriter(loops_folder, allPts);
+
 	// Add edges and triangles; edges are created if missing
 	
 	bool bornflag = false;
 	bool deadflag = false;
 	int currentv1=-1,currentv2=-1;
-    while (!ff.eof())	
+	Headers::Filtration_record record;
+    while (p_filtration->read(record))	
     {
 
 		// if(deadflag==true){
@@ -503,90 +480,58 @@ int main( int argc, char *argv[] )
 			// getchar();
 		// }
 
-    	char sLine[256]="";
-
-    	ff.getline(sLine, 256);
-    	// cout<<"sLine:"<<sLine<<"\n";
-    	if(sLine[0]=='c'||strlen(sLine)==0)
-    		continue;
-
-
-    	stringstream ss;
-		ss.str(sLine);
-		char ic;
-		int index;
-		float indf;
-		std::vector<int> simplex1;
-
-		ss >> ic;
+		int indf;
+		std::vector<int> &simplex1 = record.vertices;
 		
-		if(ic=='#'){
-			ss >> indf;
+		if(record.type==Headers::Filtration_record::MARKER){
+			indf = record.marker;
 
-			auto itf = std::find(vdead.begin(), vdead.end(), indf);
+			barEvent event;
+			event.kind = barEvent::NONE;
+			if(indf>=0 && indf<(int)vevents.size())
+				event = vevents[indf];
 			// ******************** DEAD PART *********************
-			if(itf != vdead.end() ){	
-				cout<<"Short Loop Dead:sL:"<<sLine<<"\n"; 
+			if(event.kind == barEvent::DEAD){	
+				cout<<"Short Loop Dead:sL:# "<<indf<<"\n"; 
 				// getchar();
 				// CheckBoundaryBirthOfLoops(birthOfLoops);
-				int index = std::distance(vdead.begin(), itf);
+				int index = event.bar;
 				int lid = vborn[index]; //loop_index_which_died
-				higherOrder lwd = birthOfLoops[lid]; // actual loop which died
+				if(!birthOfLoops.contains(lid)){
+					cout<<"No alive loop was born at: "<<lid;
+					exit(0);
+				}
 				// cout<<"dead: "<<lid;
 				// getchar();
-				if(nedges[lid]!=lwd.size()){
-					cout<<"Number mismatch of loops: "<<nedges[lid]<<" "<<lwd.size();
+				if(nedges[lid]!=birthOfLoops.edge_count(lid)){
+					cout<<"Number mismatch of loops: "<<nedges[lid]<<" "<<birthOfLoops.edge_count(lid);
 					exit(0);
 				}
-				lwd = modifylastloop(lwd);
+				std::vector<int> lwd = modifylastloop(birthOfLoops.endpoints(lid), birthOfLoops.edge_count(lid)); // actual loop which died
 				cout<<"Loop born at: "<<vborn[index]<<", died at: "<<vdead[index]<<"\n";
 				// cout<<"dead 2";
 				// getchar();
-				printHigherOrder(lwd);
+				printLoop(&lwd[0], lwd.size()/2);
 				// getchar();
 				// cout<<"erase";
+				loopWriter.write(lid, birthOfLoops.endpoints(lid), birthOfLoops.edge_count(lid));
 				birthOfLoops.erase(lid);
+				loopTracker.erase(lid);
 				nedges.erase(lid);
 				deadflag = true;
 				cout<<"short loop second";
-				CheckBoundaryBirthOfLoops(birthOfLoops);
+				CheckBoundaryBirthOfLoops(birthOfLoops, loopTracker);
 				// getchar();
 				continue;
 			}
 			// ******************* BORN PART ************************
-			else if (std::find(vborn.begin(), vborn.end(), indf) != vborn.end()){
+			else if (event.kind == barEvent::BORN){
 				// {cout<<"Neither constructor or destructor."<<std::endl;  continue;}	// else{
 				
 				
 				cout<<"Short Loop Born: "<<indf<<"|simplex: ";
-				CheckBoundaryBirthOfLoops(birthOfLoops);
+				CheckBoundaryBirthOfLoops(birthOfLoops, loopTracker);
 				bool loopadded = false;
-				Complex< Kernel > complex( dimensions, verbose );
-    	
-		    	for ( int itp=0; itp < noPoints; itp++ )
-				{			
-					Point p(dimensions);
-					p = allPts[itp];
-					Vertex< Kernel > *p_vertex( new Vertex< Kernel >(p));
-					complex.insert_vertex( p_vertex );
-					
-				}
-				for( int itp=0;itp<storeComplexforShortLoop.size();itp++){
-					if(storeComplexforShortLoop[itp].size()==2){
-						Vertex< Kernel > &a( complex.vertex_at( storeComplexforShortLoop[itp][0] ) );
-						Vertex< Kernel > &b( complex.vertex_at( storeComplexforShortLoop[itp][1] ) );
-						// cout<<a.index()<<"... "<<b.index()<<"|";
-						complex.create_edge( a, b, sqrt(a.location().get_squared_distance_to(b.location())) );
-					}
-					else if(storeComplexforShortLoop[itp].size()==3){
-						Vertex< Kernel > &a( complex.vertex_at( storeComplexforShortLoop[itp][0] ) );
-						Vertex< Kernel > &b( complex.vertex_at( storeComplexforShortLoop[itp][1] ) );
-						Vertex< Kernel > &c( complex.vertex_at( storeComplexforShortLoop[itp][2] ) );
-						// cout<<a.index()<<"..."<<b.index()<<"..."<<c.index()<<"|";
-						complex.create_triangle( a, b, c );
-					} 	
-
-				}
 				cout<<"\n";
 
 				cout << complex.number_of_vertices() << " vertices" << endl;
@@ -594,100 +539,114 @@ int main( int argc, char *argv[] )
 				cout << complex.number_of_triangles() << " triangles" << endl;
 				cout << complex.number_of_vertices() + complex.number_of_edges()
 				+ complex.number_of_triangles() << " simplices total" << endl;
-				complex.contract();	// builds the tree
-				complex.sample( sampling_coefficient );		// Gets a random sample from the complex.  All points are used if sampling_coefficient=1.
-				
-				complex.compute_basis();
-				
-				cout << complex.basis_rank() << " loops\n";
+				complex.update_contraction();	// brings the tree up to date
+
 				//Find which loop is born here
-				higherOrder simp2;
-				higherPoint vP;
+				std::vector<int> simp2;	//endpoints of the edges of the loop
 				cout<<"currents: "<<currentv1<<" "<<currentv2<<std::endl;
-				for ( unsigned i( 0 ); i != complex.basis_rank(); ++i )
-				{
 
-					// if(loopadded==true && indf!=564)
-						// break;
-					Basis_loop< Kernel > &basis_loop = complex.basis_loop_at( i ) ;
-					cout << "Loop " << i << " (" << basis_loop.size();
-					cout << " edges, length=" << basis_loop.norm() << "):";
-					Basis_loop< Kernel >::Iterator it_edge( basis_loop.begin() );
-					std::vector<int> interm;
-					std::vector<std::vector<float>> vP2;
-					// getchar();
-					bool containsthisedge = false;
-					for ( ; it_edge != basis_loop.end(); ++it_edge )
-					{
-						Edge< Kernel > &edge( **it_edge );
-						cout<<edge.a().index()<<" "<<edge.b().index()<<"...";
-						if((currentv1==edge.a().index() && currentv2==edge.b().index())||(currentv2==edge.a().index() && currentv1==edge.b().index()))
-							containsthisedge = true;
-						// else containsthisedge = false;
-						interm.push_back(edge.a().index());
-						interm.push_back(edge.b().index());
-						simp2.push_back(interm);
-						interm.clear();
-
-						int dimhere = edge.a().m_location.get_dim();
-
-						std::vector<float> coord;
-						for(int idim=0;idim<dimhere;idim++)
-							coord.push_back(edge.a().m_location.get_coord(idim));
-						
-						vP2.push_back(coord);
-						
-						coord.clear();
-						for(int idim=0;idim<dimhere;idim++)
-							coord.push_back(edge.b().m_location.get_coord(idim));
+				// First pass: the shortest loop through the new edge that is independent
+				// of the alive loops, found around the edge only. Second pass (or the only
+				// one with -b): every loop of the shortest homology basis.
+				Basis_loop< Kernel > *p_anchored_loop = 0;
+				for(int pass = full_basis ? 1 : 0; pass < 2 && loopadded == false; pass++)
+				{
+					std::vector< Basis_loop< Kernel > * > candidate_loops;
+					if(pass == 0){
+						Edge< Kernel > *p_edge = complex.find_edge(complex.vertex_at(currentv1), complex.vertex_at(currentv2));
+						if(p_edge == 0)
+							continue;
+
+						Z2_basis alive_classes(complex.basis_rank());
+						for(LoopStore::const_iterator itl = birthOfLoops.begin(); itl != birthOfLoops.end(); ++itl){
+							std::vector< Edge< Kernel > * > loop_edges;
+							const int *endpoints = birthOfLoops.endpoints(itl->first);
+							for(int ie=0; ie<birthOfLoops.edge_count(itl->first); ie++){
+								Edge< Kernel > *p_loop_edge = complex.find_edge(complex.vertex_at(endpoints[2*ie]), complex.vertex_at(endpoints[2*ie+1]));
+								if(p_loop_edge != 0)
+									loop_edges.push_back(p_loop_edge);
+							}
+							alive_classes.insert(complex.homology_class(loop_edges));
+						}
 
-						vP2.push_back(coord);
-						
-						vP.push_back(vP2);
-						vP2.clear();
+						p_anchored_loop = complex.shortest_nontrivial_loop_through(*p_edge, alive_classes);
+						if(p_anchored_loop == 0)
+							continue;
+						candidate_loops.push_back(p_anchored_loop);
 					}
-					// getchar();
-					cout<<"\n";
+					else{
+						complex.sample( sampling_coefficient );		// Gets a random sample from the complex.  All points are used if sampling_coefficient=1.
+
+						complex.compute_basis();
 
-					if(simp2.size()!=basis_loop.size()){
-						cout<<"Not all edges are inserted: "<<simp2.size()<<" "<<basis_loop.size()<<"\n";
-						printHigherOrder(simp2);
-						exit(0);
+						cout << complex.basis_rank() << " loops\n";
+						for ( unsigned i( 0 ); i != complex.basis_rank(); ++i )
+							candidate_loops.push_back(&complex.basis_loop_at( i ));
 					}
 
-					// Takes in the current loop and set containing all loops and 
-					// sees if this current one is independant, if so then this was born
-					if( containsthisedge==true && bornTracker(simp2,birthOfLoops)==true){
-						// cout<<"no it aint";
+					for ( unsigned i( 0 ); i != candidate_loops.size(); ++i )
+					{
+
+						// if(loopadded==true && indf!=564)
+							// break;
+						Basis_loop< Kernel > &basis_loop = *candidate_loops[i];
+						cout << "Loop " << i << " (" << basis_loop.size();
+						cout << " edges, length=" << basis_loop.norm() << "):";
+						Basis_loop< Kernel >::Iterator it_edge( basis_loop.begin() );
 						// getchar();
-						loopadded = true;
-						// if(indf==564)
-							// {cout<<"chosen: ";printHigherOrder(simp2); }
-						// getchar();}
-						int indy = loopExistenceChecker(simp2, birthOfLoops);
-						if(indy!=-1)
+						bool containsthisedge = false;
+						for ( ; it_edge != basis_loop.end(); ++it_edge )
 						{
+							Edge< Kernel > &edge( **it_edge );
+							cout<<edge.a().index()<<" "<<edge.b().index()<<"...";
+							if((currentv1==edge.a().index() && currentv2==edge.b().index())||(currentv2==edge.a().index() && currentv1==edge.b().index()))
+								containsthisedge = true;
+							// else containsthisedge = false;
+							simp2.push_back(edge.a().index());
+							simp2.push_back(edge.b().index());
+						}
+						// getchar();
+						cout<<"\n";
 
-							cout<<"Wrong born tracker: "<<std::endl;
-							printHigherOrder(simp2);
-							cout<<"**********************"<<"\n";
-							printHigherOrder(birthOfLoops[indy]);
+						if(simp2.size()!=2*basis_loop.size()){
+							cout<<"Not all edges are inserted: "<<simp2.size()/2<<" "<<basis_loop.size()<<"\n";
+							printLoop(&simp2[0], simp2.size()/2);
 							exit(0);
 						}
+
+						// Takes in the current loop and set containing all loops and 
+						// sees if this current one is independant, if so then this was born
+						if( containsthisedge==true && bornTracker(simp2,birthOfLoops,loopTracker)==true){
+							// cout<<"no it aint";
+							// getchar();
+							loopadded = true;
+							// if(indf==564)
+								// {cout<<"chosen: ";printHigherOrder(simp2); }
+							// getchar();}
+							int indy = loopExistenceChecker(simp2, birthOfLoops);
+							if(indy!=-1)
+							{
+
+								cout<<"Wrong born tracker: "<<std::endl;
+								printLoop(&simp2[0], simp2.size()/2);
+								cout<<"**********************"<<"\n";
+								printLoop(birthOfLoops.endpoints(indy), birthOfLoops.edge_count(indy));
+								exit(0);
+							}
 						
-						birthOfLoops.insert(std::pair<int, higherOrder>(indf, simp2));
-						nedges.insert(std::pair<int, int>(indf, basis_loop.size()));
-						if(simp2.size()!=basis_loop.size()){
-							cout<<"Number mismatch in loops even before insert";
-							exit(0);
+							if(birthOfLoops.insert(indf, simp2))
+								loopTracker.insert(indf, loopAnnotation(simp2));
+							nedges.insert(std::pair<int, int>(indf, basis_loop.size()));
+							if(simp2.size()!=2*basis_loop.size()){
+								cout<<"Number mismatch in loops even before insert";
+								exit(0);
+							}
 						}
-
-						vloop.insert(std::pair<int, higherPoint>(indf, vP));
-					}
-						simp2.clear();
-						vP.clear();
+							simp2.clear();
 		
-				}//"Loop basis rank"
+					}//"Loop basis rank"
+				}
+				delete p_anchored_loop;
 				// cout<<"out of basis part";
 				if(loopadded == false)
 				{
@@ -696,7 +655,7 @@ int main( int argc, char *argv[] )
 				}
 				
 				cout<<"born end";
-				CheckBoundaryBirthOfLoops(birthOfLoops);
+				CheckBoundaryBirthOfLoops(birthOfLoops, loopTracker);
 				continue;
 			}// Born Part
 
@@ -708,11 +667,6 @@ int main( int argc, char *argv[] )
 		// 	getchar();
 		// }
 
-		while (ss >> index)
-		{
-		simplex1.push_back(index);
-		}
-
 		if(simplex1.size() <= 1)
 		{
 		cout<<" vertices should already be inside. Error\n";
@@ -725,25 +679,41 @@ int main( int argc, char *argv[] )
 			currentv2 = simplex1[1];
 		}
 
-		storeComplexforShortLoop.push_back(simplex1);
+		if(simplex1.size()==2){
+			Vertex< Kernel > &a( complex.vertex_at( simplex1[0] ) );
+			Vertex< Kernel > &b( complex.vertex_at( simplex1[1] ) );
+			complex.insert_edge( a, b, sqrt(a.location().get_squared_distance_to(b.location())) );
+		}
+		else if(simplex1.size()==3){
+			Vertex< Kernel > &a( complex.vertex_at( simplex1[0] ) );
+			Vertex< Kernel > &b( complex.vertex_at( simplex1[1] ) );
+			Vertex< Kernel > &c( complex.vertex_at( simplex1[2] ) );
+			complex.insert_triangle( a, b, c );
+		}
+
 		scalecount+=1;
 		filtration_step += 1;
 		timer2 = std::clock();
 
 		vecFiltrationScale.push_back(scalecount);
 		domain_complex.ElementaryInsersion(simplex1);
-		simplex1.clear();
 			
 		complexSizes.push_back(domain_complex.ComplexSize());
 		accumulativeSizes.push_back(domain_complex.accumulativeSimplexSize);
 		dFuncTimeSum += (std::clock() - timer2);
+
+		if(filtration_step % PAIRS_FLUSH_INTERVAL == 0)
+			flushPersistencePairs(pairsOut);
 		
     }//end of while going through each line of the simpers code
 
 // cout<<"this part";
 // getchar();
 
-loopPrinting(vloop, loops_folder);
+for(LoopStore::const_iterator itl = birthOfLoops.begin(); itl != birthOfLoops.end(); ++itl)
+	loopWriter.write(itl->first, birthOfLoops.endpoints(itl->first), birthOfLoops.edge_count(itl->first));
+loopWriter.finish();
+flushPersistencePairs(pairsOut, true);
 return 1;
 
 }// end of main
\ No newline at end of file